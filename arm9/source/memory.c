@@ -34,20 +34,24 @@
 u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
 {
     const u8 *patternc = (const u8 *)pattern;
-    u32 table[256];
+    u8 table[256];
 
-    //Preprocessing
-    for(u32 i = 0; i < 256; i++)
-        table[i] = patternSize;
-    for(u32 i = 0; i < patternSize - 1; i++)
+    if(patternSize == 0 || patternSize > size) return NULL;
+
+    //Preprocessing, shifts are capped to 255 so that the table fits in 256 bytes
+    u32 maxShift = patternSize < 0xFF ? patternSize : 0xFF;
+    memset(table, maxShift, sizeof(table));
+    for(u32 i = patternSize - maxShift; i < patternSize - 1; i++)
         table[patternc[i]] = patternSize - i - 1;
 
-    //Searching
+    //Searching, the last and first bytes are checked before comparing the whole pattern
+    u8 last = patternc[patternSize - 1],
+       first = patternc[0];
     u32 j = 0;
     while(j <= size - patternSize)
     {
         u8 c = startPos[j + patternSize - 1];
-        if(patternc[patternSize - 1] == c && memcmp(pattern, startPos + j, patternSize - 1) == 0)
+        if(c == last && startPos[j] == first && memcmp(pattern, startPos + j, patternSize - 1) == 0)
             return startPos + j;
         j += table[c];
     }
@@ -1,5 +1,6 @@
 #include "bps_patcher.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <optional>
@@ -21,6 +22,32 @@ extern "C"
 
 namespace patcher
 {
+class ScopedAppHeap
+{
+public:
+    ScopedAppHeap(u32 size) : m_size{(size + 0xFFF) & ~0xFFF}
+    {
+        u32 tmp;
+        if(!R_SUCCEEDED(svcControlMemory(&tmp, BaseAddress, 0, m_size,
+                                         MemOp(MEMOP_ALLOC | MEMOP_REGION_APP),
+                                         MemPerm(MEMPERM_READ | MEMPERM_WRITE))))
+        {
+            svcBreak(USERBREAK_PANIC);
+        }
+    }
+
+    ~ScopedAppHeap()
+    {
+        u32 tmp;
+        svcControlMemory(&tmp, BaseAddress, 0, m_size, MEMOP_FREE, MemPerm(0));
+    }
+
+    static constexpr u32 BaseAddress = 0x08000000;
+
+private:
+    u32 m_size;
+};
+
 namespace Bps
 {
 // The BPS format uses variable length encoding for all integers.
@@ -30,6 +57,8 @@ using Number = u32;
 constexpr std::size_t FooterSize = 12;
 
 // The BPS format uses CRC32 checksums.
+#ifdef BPS_CRC32_SMALL
+// Bit by bit implementation, for when code size matters more than speed.
 [[gnu::optimize("Os")]] static u32 crc32(const u8 *data, std::size_t size)
 {
     u32 crc = 0xFFFFFFFF;
@@ -44,6 +73,56 @@ constexpr std::size_t FooterSize = 12;
     }
     return ~crc;
 }
+#else
+// Slice-by-4 tables: Crc32Tables[0] is the classic byte table, and Crc32Tables[k][b] is the CRC of
+// byte b followed by k zero bytes, which lets the main loop consume a whole word per iteration.
+static constexpr auto MakeCrc32Tables()
+{
+    std::array<std::array<u32, 256>, 4> tables{};
+    for(u32 i = 0; i < 256; ++i)
+    {
+        u32 crc = i;
+        for(std::size_t j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        tables[0][i] = crc;
+    }
+    for(u32 i = 0; i < 256; ++i)
+    {
+        for(std::size_t k = 1; k < tables.size(); ++k)
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+    }
+    return tables;
+}
+
+static constexpr auto Crc32Tables = MakeCrc32Tables();
+
+static u32 crc32(const u8 *data, std::size_t size)
+{
+    u32 crc = 0xFFFFFFFF;
+
+    for(; size != 0 && (reinterpret_cast<uintptr_t>(data) & 3) != 0; --size)
+        crc = (crc >> 8) ^ Crc32Tables[0][(crc ^ *data++) & 0xFF];
+
+    for(; size >= 4; size -= 4, data += 4)
+    {
+        u32 word;
+        std::memcpy(&word, data, sizeof(word));
+        crc ^= word;
+        crc = Crc32Tables[3][crc & 0xFF] ^ Crc32Tables[2][(crc >> 8) & 0xFF] ^
+              Crc32Tables[1][(crc >> 16) & 0xFF] ^ Crc32Tables[0][crc >> 24];
+    }
+
+    for(; size != 0; --size)
+        crc = (crc >> 8) ^ Crc32Tables[0][(crc ^ *data++) & 0xFF];
+
+    return ~crc;
+}
+#endif
+
+// Patch data is read from the file in chunks of this size instead of being loaded whole.
+// The loader only has a 4 KiB stack, hence the static buffer.
+constexpr std::size_t PatchChunkSize = 0x1000;
+static u8 s_patch_chunk[PatchChunkSize];
 
 // Utility class to make keeping track of offsets and bound checks less error prone.
 template <typename T>
@@ -61,8 +140,8 @@ public:
         return true;
     }
 
-    template <typename OtherType>
-    [[gnu::optimize("Os")]] bool CopyFrom(Stream<OtherType> &other, std::size_t length)
+    template <typename OtherStream>
+    [[gnu::optimize("Os")]] bool CopyFrom(OtherStream &other, std::size_t length)
     {
         if(m_offset + length > m_size)
             return false;
@@ -72,6 +151,60 @@ public:
         return true;
     }
 
+    auto data() const { return m_ptr; }
+    std::size_t size() const { return m_size; }
+    std::size_t Tell() const { return m_offset; }
+
+    bool Seek(size_t offset)
+    {
+        m_offset = offset;
+        return true;
+    }
+
+private:
+    T *m_ptr = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_offset = 0;
+};
+
+// Same interface as Stream, but backed by a file of which only one chunk is kept in memory.
+class FileStream
+{
+public:
+    FileStream(util::File &file, std::size_t size) : m_file{file}, m_size{size} {}
+
+    bool Read(void *buffer, std::size_t length)
+    {
+        if(m_offset + length > m_size)
+            return false;
+
+        u8 *out = static_cast<u8 *>(buffer);
+        while(length != 0)
+        {
+            if(m_offset < m_chunk_offset || m_offset >= m_chunk_offset + m_chunk_size)
+            {
+                // Large reads go straight to their destination.
+                if(length >= PatchChunkSize)
+                {
+                    if(!m_file.Read(out, length, m_offset))
+                        return false;
+                    m_offset += length;
+                    return true;
+                }
+                if(!Fill())
+                    return false;
+            }
+
+            const std::size_t chunk_pos = m_offset - m_chunk_offset;
+            const std::size_t count = std::min(length, m_chunk_size - chunk_pos);
+            std::memcpy(out, s_patch_chunk + chunk_pos, count);
+            out += count;
+            m_offset += count;
+            length -= count;
+        }
+        return true;
+    }
+
     template <typename ValueType>
     std::optional<ValueType> Read()
     {
@@ -82,22 +215,34 @@ public:
         return val;
     }
 
-    [[gnu::optimize("Os")]] Number ReadNumber()
+    Number ReadNumber()
     {
         Number data = 0, shift = 1;
-        std::optional<u8> x;
-        while((x = Read<u8>()))
+        while(m_offset < m_size)
         {
-            data += (*x & 0x7f) * shift;
-            if(*x & 0x80)
+            if((m_offset < m_chunk_offset || m_offset >= m_chunk_offset + m_chunk_size) && !Fill())
                 break;
-            shift <<= 7;
-            data += shift;
+
+            // Decode straight from the chunk buffer, only going back to Fill() when the number straddles two chunks.
+            const u8 *pos = s_patch_chunk + (m_offset - m_chunk_offset);
+            const u8 *end = s_patch_chunk + m_chunk_size;
+            while(pos != end)
+            {
+                const u8 x = *pos++;
+                data += (x & 0x7f) * shift;
+                if(x & 0x80)
+                {
+                    m_offset = m_chunk_offset + (pos - s_patch_chunk);
+                    return data;
+                }
+                shift <<= 7;
+                data += shift;
+            }
+            m_offset = m_chunk_offset + m_chunk_size;
         }
         return data;
     }
 
-    auto data() const { return m_ptr; }
     std::size_t size() const { return m_size; }
     std::size_t Tell() const { return m_offset; }
 
@@ -108,43 +253,72 @@ public:
     }
 
 private:
-    T *m_ptr = nullptr;
+    bool Fill()
+    {
+        m_chunk_offset = m_offset;
+        m_chunk_size = std::min(PatchChunkSize, m_size - m_offset);
+        return m_file.Read(s_patch_chunk, m_chunk_size, m_chunk_offset);
+    }
+
+    util::File &m_file;
     std::size_t m_size = 0;
     std::size_t m_offset = 0;
+    std::size_t m_chunk_offset = 0;
+    std::size_t m_chunk_size = 0;
 };
 
+// Applies the patch in place: the code buffer is both the source and the target.
+//
+// The target is written sequentially, so everything at or after the current target offset
+// still holds source data. SourceRead commands then have nothing to copy, and SourceCopy
+// commands reading at or after the current target offset can move data within the buffer.
+// Only SourceCopy commands reading behind the target offset need the original bytes; a pre-pass
+// over the patch finds the range they cover so that only this range is saved beforehand.
 class PatchApplier
 {
 public:
-    PatchApplier(Stream<const u8> source, Stream<u8> target, Stream<const u8> patch)
-        : m_source{source}, m_target{target}, m_patch{patch}
+    PatchApplier(u8 *code, std::size_t size, FileStream patch)
+        : m_target{code, size}, m_patch{patch}
     {
     }
 
     [[gnu::always_inline]] bool Apply()
     {
-        const auto magic = *m_patch.Read<std::array<char, 4>>();
-        if(std::string_view(magic.data(), magic.size()) != "BPS1")
+        const auto magic = m_patch.Read<std::array<char, 4>>();
+        if(!magic || std::string_view(magic->data(), magic->size()) != "BPS1")
             return false;
 
         const Bps::Number source_size = m_patch.ReadNumber();
         const Bps::Number target_size = m_patch.ReadNumber();
         const Bps::Number metadata_size = m_patch.ReadNumber();
-        if(source_size > m_source.size() || target_size > m_target.size() || metadata_size != 0)
+        if(source_size > m_target.size() || target_size > m_target.size() || metadata_size != 0)
             return false;
 
         const std::size_t command_start_offset = m_patch.Tell();
+        if(m_patch.size() < command_start_offset + FooterSize)
+            return false;
         const std::size_t command_end_offset = m_patch.size() - FooterSize;
         m_patch.Seek(command_end_offset);
         const u32 source_crc32 = *m_patch.Read<u32>();
         const u32 target_crc32 = *m_patch.Read<u32>();
         m_patch.Seek(command_start_offset);
 
-        if(crc32(m_source.data(), source_size) != source_crc32)
+        if(crc32(m_target.data(), source_size) != source_crc32)
             return false;
 
+        FindSavedSourceRange(command_end_offset);
+        m_patch.Seek(command_start_offset);
+
+        // Temporarily use APPLICATION memory to keep the source data that will be overwritten before being read.
+        std::optional<ScopedAppHeap> memory;
+        if(m_saved_source_end > m_saved_source_start)
+        {
+            memory.emplace(m_saved_source_end - m_saved_source_start);
+            m_saved_source = reinterpret_cast<u8 *>(ScopedAppHeap::BaseAddress);
+            std::memcpy(m_saved_source, m_target.data() + m_saved_source_start, m_saved_source_end - m_saved_source_start);
+        }
+
         // Process all patch commands.
-        std::memset(m_target.data(), 0, m_target.size());
         while(m_patch.Tell() < command_end_offset)
         {
             const bool ok = HandleCommand();
@@ -152,10 +326,46 @@ public:
                 return false;
         }
 
+        std::memset(m_target.data() + m_target.Tell(), 0, m_target.size() - m_target.Tell());
         return crc32(m_target.data(), target_size) == target_crc32;
     }
 
 private:
+    void FindSavedSourceRange(std::size_t command_end_offset)
+    {
+        std::size_t target_offset = 0;
+        std::size_t source_relative_offset = 0;
+
+        m_saved_source_start = m_target.size();
+        m_saved_source_end = 0;
+
+        while(m_patch.Tell() < command_end_offset)
+        {
+            const Number data = m_patch.ReadNumber();
+            const Number command = data & 3;
+            const Number length = (data >> 2) + 1;
+
+            if(command == 1)
+                m_patch.Seek(m_patch.Tell() + length);
+            else if(command == 2 || command == 3)
+            {
+                const Number offset = m_patch.ReadNumber();
+                if(command == 2)
+                {
+                    source_relative_offset += (offset & 1 ? -1 : +1) * int(offset >> 1);
+                    if(source_relative_offset < target_offset)
+                    {
+                        m_saved_source_start = std::min(m_saved_source_start, source_relative_offset);
+                        m_saved_source_end = std::max(m_saved_source_end, std::min(source_relative_offset + length, m_target.size()));
+                    }
+                    source_relative_offset += length;
+                }
+            }
+
+            target_offset += length;
+        }
+    }
+
     bool HandleCommand()
     {
         const Number data = m_patch.ReadNumber();
@@ -179,7 +389,11 @@ private:
 
     bool SourceRead(Number length)
     {
-        return m_source.Seek(m_target.Tell()) && m_target.CopyFrom(m_source, length);
+        // The source data is already where it belongs.
+        if(m_target.Tell() + length > m_target.size())
+            return false;
+        m_target.Seek(m_target.Tell() + length);
+        return true;
     }
 
     bool TargetRead(Number length) { return m_target.CopyFrom(m_patch, length); }
@@ -188,8 +402,18 @@ private:
     {
         const Number data = m_patch.ReadNumber();
         m_source_relative_offset += (data & 1 ? -1 : +1) * int(data >> 1);
-        if(!m_source.Seek(m_source_relative_offset) || !m_target.CopyFrom(m_source, length))
+        if(m_target.Tell() + length > m_target.size() || m_source_relative_offset + length > m_target.size())
+            return false;
+
+        u8 *dst = m_target.data() + m_target.Tell();
+        if(m_source_relative_offset >= m_target.Tell())
+            std::memmove(dst, m_target.data() + m_source_relative_offset, length);
+        else if(m_source_relative_offset >= m_saved_source_start && m_source_relative_offset + length <= m_saved_source_end)
+            std::memcpy(dst, m_saved_source + (m_source_relative_offset - m_saved_source_start), length);
+        else
             return false;
+
+        m_target.Seek(m_target.Tell() + length);
         m_source_relative_offset += length;
         return true;
     }
@@ -200,51 +424,46 @@ private:
         m_target_relative_offset += (data & 1 ? -1 : +1) * int(data >> 1);
         if(m_target.Tell() + length > m_target.size())
             return false;
-        if(m_target_relative_offset + length > m_target.size())
+        // Only data that has already been written can be copied.
+        if(m_target_relative_offset >= m_target.Tell())
             return false;
-        // Byte by byte copy.
-        for(size_t i = 0; i < length; ++i)
-            m_target.data()[m_target.Tell() + i] = m_target.data()[m_target_relative_offset++];
+
+        // The copy behaves as if done byte by byte, so when the regions overlap the output repeats
+        // with a period of the distance between them. Runs of a single byte are fills, and other
+        // overlapping copies are done in non-overlapping blocks whose size doubles each time.
+        u8 *dst = m_target.data() + m_target.Tell();
+        const u8 *src = m_target.data() + m_target_relative_offset;
+        std::size_t distance = dst - src;
+        if(distance == 1)
+            std::memset(dst, *src, length);
+        else
+        {
+            for(std::size_t remaining = length; remaining != 0;)
+            {
+                const std::size_t count = std::min(remaining, distance);
+                std::memcpy(dst, src, count);
+                dst += count;
+                remaining -= count;
+                distance += count;
+            }
+        }
+
+        m_target_relative_offset += length;
         m_target.Seek(m_target.Tell() + length);
         return true;
     }
 
     std::size_t m_source_relative_offset = 0;
     std::size_t m_target_relative_offset = 0;
-    Stream<const u8> m_source;
+    std::size_t m_saved_source_start = 0;
+    std::size_t m_saved_source_end = 0;
+    u8 *m_saved_source = nullptr;
     Stream<u8> m_target;
-    Stream<const u8> m_patch;
+    FileStream m_patch;
 };
 
 }  // namespace Bps
 
-class ScopedAppHeap
-{
-public:
-    ScopedAppHeap()
-    {
-        u32 tmp;
-        m_size = osGetMemRegionFree(MEMREGION_APPLICATION);
-        if(!R_SUCCEEDED(svcControlMemory(&tmp, BaseAddress, 0, m_size,
-                                         MemOp(MEMOP_ALLOC | MEMOP_REGION_APP),
-                                         MemPerm(MEMPERM_READ | MEMPERM_WRITE))))
-        {
-            svcBreak(USERBREAK_PANIC);
-        }
-    }
-
-    ~ScopedAppHeap()
-    {
-        u32 tmp;
-        svcControlMemory(&tmp, BaseAddress, 0, m_size, MEMOP_FREE, MemPerm(0));
-    }
-
-    static constexpr u32 BaseAddress = 0x08000000;
-
-private:
-    u32 m_size;
-};
-
 static inline bool ApplyCodeBpsPatch(u64 prog_id, u8 *code, u32 size)
 {
     char bps_path[] = "/luma/titles/0000000000000000/code.bps";
@@ -254,19 +473,8 @@ static inline bool ApplyCodeBpsPatch(u64 prog_id, u8 *code, u32 size)
         return true;
     const u32 patch_size = u32(patch_file.GetSize().value_or(0));
 
-    // Temporarily use APPLICATION memory to store the source and patch data.
-    ScopedAppHeap memory;
-
-    u8 *source_data = reinterpret_cast<u8 *>(memory.BaseAddress);
-    u8 *patch_data = source_data + size;
-    std::memcpy(source_data, code, size);
-    if(!patch_file.Read(patch_data, patch_size, 0))
-        return false;
-
-    Bps::Stream<const u8> source_stream{source_data, size};
-    Bps::Stream target_stream{code, size};
-    Bps::Stream<const u8> patch_stream{patch_data, patch_size};
-    Bps::PatchApplier applier{source_stream, target_stream, patch_stream};
+    Bps::FileStream patch_stream{patch_file, patch_size};
+    Bps::PatchApplier applier{code, size, patch_stream};
     if(!applier.Apply())
         svcBreak(USERBREAK_PANIC);
     return true;
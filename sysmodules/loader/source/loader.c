@@ -4,6 +4,8 @@
 #include "ifile.h"
 #include "util.h"
 #include "hbldr.h"
+#include "lzss.h"
+#include "my_thread.h"
 #include "luma_shared_config.h"
 
 extern u32 config, multiConfig, bootConfig;
@@ -26,70 +28,78 @@ typedef struct prog_addrs_t
     u32 total_size;
 } prog_addrs_t;
 
-static int lzss_decompress(u8 *end)
+//Compressed .code files bigger than this are read by a separate thread, in chunks of this size, while being decompressed
+#define CODE_READ_CHUNK_SIZE 0x10000
+
+typedef struct CodeReader
+{
+    Handle file;
+    u8 *buffer;
+    u32 size;
+    u32 lowestRead;
+    LightEvent chunkReadEvent;
+} CodeReader;
+
+static MyThread g_codeReaderThread;
+static u8 ALIGN(8) g_codeReaderThreadStack[THREAD_STACK_SIZE];
+static CodeReader g_codeReader;
+
+//The compressed data is decompressed from its end, so the file is read from its end as well
+static void codeReaderThreadMain(void *p)
 {
-    unsigned int v1; // r1@2
-    u8 *v2; // r2@2
-    u8 *v3; // r3@2
-    u8 *v4; // r1@2
-    char v5; // r5@4
-    char v6; // t1@4
-    signed int v7; // r6@4
-    int v9; // t1@7
-    u8 *v11; // r3@8
-    int v12; // r12@8
-    int v13; // t1@8
-    int v14; // t1@8
-    unsigned int v15; // r7@8
-    int v16; // r12@8
-    int ret;
-
-    ret = 0;
-    if ( end )
+    CodeReader *reader = (CodeReader *)p;
+
+    for(u32 offset = reader->size; offset > 0;)
     {
-        v1 = *((u32 *)end - 2);
-        v2 = &end[*((u32 *)end - 1)];
-        v3 = &end[-(v1 >> 24)];
-        v4 = &end[-(v1 & 0xFFFFFF)];
-        while ( v3 > v4 )
+        u32 chunkSize = offset < CODE_READ_CHUNK_SIZE ? offset : CODE_READ_CHUNK_SIZE,
+            total;
+
+        offset -= chunkSize;
+
+        //Short reads are completed, but the file must not end early: the rest of the chunk would be uninitialized
+        for(u32 pos = 0; pos < chunkSize; pos += total)
         {
-            v6 = *(v3-- - 1);
-            v5 = v6;
-            v7 = 8;
-            while ( 1 )
-            {
-                if ( (v7-- < 1) )
-                    break;
-                if ( v5 & 0x80 )
-                {
-                    v13 = *(v3 - 1);
-                    v11 = v3 - 1;
-                    v12 = v13;
-                    v14 = *(v11 - 1);
-                    v3 = v11 - 1;
-                    v15 = ((v14 | (v12 << 8)) & 0xFFFF0FFF) + 2;
-                    v16 = v12 + 32;
-                    do
-                    {
-                        ret = v2[v15];
-                        *(v2-- - 1) = ret;
-                        v16 -= 16;
-                    }
-                    while ( !(v16 < 0) );
-                }
-                else
-                {
-                    v9 = *(v3-- - 1);
-                    ret = v9;
-                    *(v2-- - 1) = v9;
-                }
-                v5 *= 2;
-                if ( v3 <= v4 )
-                    return ret;
-            }
+            assertSuccess(FSFILE_Read(reader->file, &total, offset + pos, reader->buffer + offset + pos, chunkSize - pos));
+            if(total == 0)
+                svcBreak(USERBREAK_ASSERT);
         }
+
+        __atomic_store_n(&reader->lowestRead, offset, __ATOMIC_RELEASE);
+        LightEvent_Signal(&reader->chunkReadEvent);
     }
-    return ret;
+}
+
+//Waits until everything from offset to the end of the file has been read, returns how much has been read
+static u32 waitForCodeChunk(CodeReader *reader, u32 offset)
+{
+    u32 lowestRead;
+
+    while((lowestRead = __atomic_load_n(&reader->lowestRead, __ATOMIC_ACQUIRE)) > offset)
+        LightEvent_Wait(&reader->chunkReadEvent);
+
+    return lowestRead;
+}
+
+static void readAndDecompressCode(Handle file, u8 *buffer, u32 size)
+{
+    LzssContext ctx;
+
+    g_codeReader.file = file;
+    g_codeReader.buffer = buffer;
+    g_codeReader.size = size;
+    g_codeReader.lowestRead = size;
+    LightEvent_Init(&g_codeReader.chunkReadEvent, RESET_ONESHOT);
+
+    //Higher priority than ours, so that the next read is issued as soon as the previous one completes
+    assertSuccess(MyThread_Create(&g_codeReaderThread, codeReaderThreadMain, &g_codeReader, g_codeReaderThreadStack, THREAD_STACK_SIZE, 0x13, -2));
+
+    u32 lowestRead = waitForCodeChunk(&g_codeReader, size - 8);
+    lzssInit(&ctx, buffer + size);
+
+    while(!lzssDecompressUntil(&ctx, buffer + lowestRead))
+        lowestRead = waitForCodeChunk(&g_codeReader, lowestRead - 1);
+
+    assertSuccess(MyThread_Join(&g_codeReaderThread, -1LL));
 }
 
 static inline bool hbldrIs3dsxTitle(u64 tid)
@@ -138,13 +148,22 @@ static Result loadCode(u64 titleId, prog_addrs_t *shared, u64 programHandle, int
             return 0xC900464F;
         }
 
-        // read code
-        assertSuccess(IFile_Read(&file, &total, (void *)shared->text_addr, size));
-        IFile_Close(&file); // done reading
+        if (isCompressed && size > CODE_READ_CHUNK_SIZE)
+        {
+            // read and decompress at the same time
+            readAndDecompressCode(file.handle, (u8 *)shared->text_addr, (u32)size);
+            IFile_Close(&file);
+        }
+        else
+        {
+            // read code
+            assertSuccess(IFile_Read(&file, &total, (void *)shared->text_addr, size));
+            IFile_Close(&file); // done reading
 
-        // decompress
-        if (isCompressed)
-            lzss_decompress((u8 *)shared->text_addr + size);
+            // decompress
+            if (isCompressed)
+                lzssDecompress((u8 *)shared->text_addr + size);
+        }
     }
 
     ExHeader_CodeSetInfo *csi = &g_exheaderInfo.sci.codeset_info;
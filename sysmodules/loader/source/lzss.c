@@ -0,0 +1,87 @@
+#include "lzss.h"
+
+/* Decompresses, in place, a buffer compressed with the backwards LZSS variant used for ExeFS .code.
+
+   The compressed data ends with a footer of two words:
+       end[-8]: bits 0-23 are the size of the compressed region (counted back from the end of the buffer),
+                bits 24-31 are the size of the footer and its padding
+       end[-4]: how much larger the decompressed data is than the compressed buffer
+
+   Both the input and the output are processed from the end towards the beginning. Each flag byte
+   describes the next 8 tokens, MSB first: a clear bit is a literal byte, a set bit is a back-reference
+   given by two bytes, with a length of (hi >> 4) + 3 and a displacement of (((hi << 8) | lo) & 0xFFF) + 3
+   from the byte being written. The output cursor always stays ahead of the input cursor. */
+void lzssInit(LzssContext *ctx, u8 *end)
+{
+    u32 bufferInfo = *(const u32 *)(end - 8);
+
+    ctx->src = end - (bufferInfo >> 24);
+    ctx->srcStart = end - (bufferInfo & 0xFFFFFF);
+    ctx->dst = end + *(const u32 *)(end - 4);
+}
+
+//A group of 8 tokens takes at most 17 bytes of input (a flag byte and 8 back-references)
+#define LZSS_MAX_GROUP_SIZE 17
+
+/* Decompresses as long as the input needed is at or above srcLimit, so that decompression can start before
+   all of the input has been read. Returns true once everything has been decompressed. */
+bool lzssDecompressUntil(LzssContext *ctx, const u8 *srcLimit)
+{
+    const u8 *src = ctx->src,
+             *srcStart = ctx->srcStart;
+    u8 *dst = ctx->dst;
+
+    while(src > srcStart)
+    {
+        if(srcLimit > srcStart && src - srcLimit < LZSS_MAX_GROUP_SIZE)
+            break;
+
+        u8 flags = *--src;
+
+        //8 literals in a row, the most common token group in code
+        if(flags == 0 && src - srcStart >= 8)
+        {
+            src -= 8;
+            dst -= 8;
+            memmove(dst, src, 8);
+            continue;
+        }
+
+        for(u32 i = 0; i < 8 && src > srcStart; i++, flags <<= 1)
+        {
+            if(flags & 0x80)
+            {
+                u32 hi = *--src,
+                    lo = *--src,
+                    length = (hi >> 4) + 3,
+                    distance = (((hi << 8) | lo) & 0xFFF) + 3;
+
+                dst -= length;
+
+                //Non-overlapping back-references can be copied as a block
+                if(distance >= length)
+                    memcpy(dst, dst + distance, length);
+                else
+                {
+                    for(u32 j = length; j > 0; j--)
+                        dst[j - 1] = dst[j - 1 + distance];
+                }
+            }
+            else
+                *--dst = *--src;
+        }
+    }
+
+    ctx->src = src;
+    ctx->dst = dst;
+
+    return src <= srcStart;
+}
+
+void lzssDecompress(u8 *end)
+{
+    LzssContext ctx;
+
+    lzssInit(&ctx, end);
+    lzssDecompressUntil(&ctx, ctx.srcStart);
+}
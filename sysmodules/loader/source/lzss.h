@@ -0,0 +1,14 @@
+#pragma once
+
+#include <3ds/types.h>
+#include <string.h>
+
+typedef struct LzssContext
+{
+    const u8 *src, *srcStart;
+    u8 *dst;
+} LzssContext;
+
+void lzssInit(LzssContext *ctx, u8 *end);
+bool lzssDecompressUntil(LzssContext *ctx, const u8 *srcLimit);
+void lzssDecompress(u8 *end);
@@ -4,23 +4,102 @@
 u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
 {
     const u8 *patternc = (const u8 *)pattern;
-    u32 table[256];
+    u8 table[256];
 
-    //Preprocessing
-    for(u32 i = 0; i < 256; i++)
-        table[i] = patternSize;
-    for(u32 i = 0; i < patternSize - 1; i++)
+    if(patternSize == 0 || patternSize > size) return NULL;
+
+    //Preprocessing, shifts are capped to 255 so that the table fits in 256 bytes
+    u32 maxShift = patternSize < 0xFF ? patternSize : 0xFF;
+    memset(table, maxShift, sizeof(table));
+    for(u32 i = patternSize - maxShift; i < patternSize - 1; i++)
         table[patternc[i]] = patternSize - i - 1;
 
-    //Searching
+    //Searching, the last and first bytes are checked before comparing the whole pattern
+    u8 last = patternc[patternSize - 1],
+       first = patternc[0];
     u32 j = 0;
     while(j <= size - patternSize)
     {
         u8 c = startPos[j + patternSize - 1];
-        if(patternc[patternSize - 1] == c && memcmp(pattern, startPos + j, patternSize - 1) == 0)
+        if(c == last && startPos[j] == first && memcmp(pattern, startPos + j, patternSize - 1) == 0)
             return startPos + j;
         j += table[c];
     }
 
     return NULL;
 }
+
+//Set Horspool: looks for the first occurrence of every pattern in a single pass, shifting by the smallest safe amount among all of them
+u32 memsearchMulti(u8 *startPos, u32 size, MemsearchPattern *patterns, u32 count)
+{
+    u32 minSize = 0xFFFFFFFF,
+        found = 0;
+    u8 table[256];
+
+    for(u32 i = 0; i < count; i++)
+    {
+        patterns[i].result = NULL;
+        if(patterns[i].size < minSize) minSize = patterns[i].size;
+    }
+
+    if(count == 0 || minSize == 0 || minSize > size) return 0;
+
+    //Preprocessing, only the first minSize bytes of each pattern take part in the shift
+    u32 maxShift = minSize < 0xFF ? minSize : 0xFF;
+    memset(table, maxShift, sizeof(table));
+    for(u32 i = 0; i < count; i++)
+    {
+        const u8 *patternc = (const u8 *)patterns[i].pattern;
+
+        for(u32 k = 0; k < minSize - 1; k++)
+        {
+            u32 shift = minSize - k - 1;
+            if(shift < table[patternc[k]]) table[patternc[k]] = shift;
+        }
+    }
+
+    //Searching
+    u32 j = 0;
+    while(j <= size - minSize)
+    {
+        u8 c = startPos[j + minSize - 1];
+
+        for(u32 i = 0; i < count; i++)
+        {
+            const u8 *patternc = (const u8 *)patterns[i].pattern;
+            u32 patternSize = patterns[i].size;
+
+            if(patterns[i].result != NULL || patternc[minSize - 1] != c || j + patternSize > size) continue;
+            if(memcmp(patternc, startPos + j, patternSize) != 0) continue;
+
+            patterns[i].result = startPos + j;
+            if(++found == count) return found;
+        }
+
+        j += table[c];
+    }
+
+    return found;
+}
+
+//Updates results after patchSize bytes at patchPos have been overwritten, so that they're what memsearchMulti would find in
+//the patched code. Only matches overlapping the patch can appear or disappear, so only that window is searched again
+//(or what follows it, when the match that was there is gone)
+void memsearchMultiUpdate(u8 *startPos, u32 size, MemsearchPattern *patterns, u32 count, u8 *patchPos, u32 patchSize)
+{
+    for(u32 i = 0; i < count; i++)
+    {
+        u32 before = patterns[i].size - 1;
+        u8 *windowStart = (u32)(patchPos - startPos) >= before ? patchPos - before : startPos,
+           *windowEnd = patchPos + patchSize + before,
+           *end = startPos + size;
+
+        if(patterns[i].result != NULL && patterns[i].result < windowStart) continue;
+
+        bool inWindow = patterns[i].result != NULL && patterns[i].result < patchPos + patchSize;
+        if(!inWindow && windowEnd < end) end = windowEnd;
+
+        u8 *found = memsearch(windowStart, patterns[i].pattern, end - windowStart, patterns[i].size);
+        if(found != NULL || inWindow) patterns[i].result = found;
+    }
+}
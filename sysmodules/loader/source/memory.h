@@ -3,4 +3,13 @@
 #include <3ds/types.h>
 #include <string.h>
 
+typedef struct MemsearchPattern
+{
+    const void *pattern;
+    u32 size;
+    u8 *result;
+} MemsearchPattern;
+
 u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize);
+u32 memsearchMulti(u8 *startPos, u32 size, MemsearchPattern *patterns, u32 count);
+void memsearchMultiUpdate(u8 *startPos, u32 size, MemsearchPattern *patterns, u32 count, u8 *patchPos, u32 patchSize);
@@ -28,6 +28,19 @@ static u32 patchMemory(u8 *start, u32 size, const void *pattern, u32 patSize, s3
     return i;
 }
 
+//Patches at the result of patterns[0], then updates the results of the patterns that follow as if they had been
+//searched for after that patch, like patchMemory calls one after the other would
+static bool patchMemsearchResult(u8 *start, u32 size, MemsearchPattern *patterns, u32 count, s32 offset, const void *replace, u32 repSize)
+{
+    if(patterns[0].result == NULL) return false;
+
+    u8 *pos = patterns[0].result + offset;
+    memcpy(pos, replace, repSize);
+    memsearchMultiUpdate(start, size, patterns + 1, count - 1, pos, repSize);
+
+    return true;
+}
+
 static Result fileOpen(IFile *file, FS_ArchiveID archiveId, const char *path, u32 flags)
 {
     return IFile_Open(file, archiveId, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), flags);
@@ -259,6 +272,54 @@ static inline bool findLayeredFsPayloadOffset(u8 *code, u32 size, u32 roSize, u3
     return *payloadOffset != 0 && *pathOffset != 0;
 }
 
+//Buffered reader for IPS patches, so that every record header doesn't take its own FS request
+typedef struct IpsReader
+{
+    IFile *file;
+    u64 remaining;
+    u32 pos,
+        size;
+} IpsReader;
+
+static u8 ipsBuffer[0x1000];
+
+static bool ipsRead(IpsReader *reader, void *dst, u32 len)
+{
+    u8 *out = (u8 *)dst;
+    u32 buffered = reader->size - reader->pos;
+
+    if(buffered < len)
+    {
+        if(len - buffered > reader->remaining) return false;
+
+        memcpy(out, ipsBuffer + reader->pos, buffered);
+        out += buffered;
+        len -= buffered;
+        reader->pos = reader->size = 0;
+
+        u64 total;
+
+        //Large record data is read straight to its destination
+        if(len >= sizeof(ipsBuffer))
+        {
+            reader->remaining -= len;
+            return R_SUCCEEDED(IFile_Read(reader->file, &total, out, len)) && total == len;
+        }
+
+        u32 chunkSize = reader->remaining < sizeof(ipsBuffer) ? (u32)reader->remaining : sizeof(ipsBuffer);
+
+        if(R_FAILED(IFile_Read(reader->file, &total, ipsBuffer, chunkSize)) || total != chunkSize) return false;
+
+        reader->remaining -= chunkSize;
+        reader->size = chunkSize;
+    }
+
+    memcpy(out, ipsBuffer + reader->pos, len);
+    reader->pos += len;
+
+    return true;
+}
+
 static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
 {
     /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/code.ips"
@@ -272,12 +333,12 @@ static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
     if(!openLumaFile(&file, path)) return true;
 
     bool ret = false;
+    IpsReader reader = { &file, 0, 0, 0 };
     u8 buffer[5];
-    u64 total;
 
-    if(R_FAILED(IFile_Read(&file, &total, buffer, 5)) || total != 5 || memcmp(buffer, "PATCH", 5) != 0) goto exit;
+    if(R_FAILED(IFile_GetSize(&file, &reader.remaining)) || !ipsRead(&reader, buffer, 5) || memcmp(buffer, "PATCH", 5) != 0) goto exit;
 
-    while(R_SUCCEEDED(IFile_Read(&file, &total, buffer, 3)) && total == 3)
+    while(ipsRead(&reader, buffer, 3))
     {
         if(memcmp(buffer, "EOF", 3) == 0)
         {
@@ -287,29 +348,25 @@ static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
 
         u32 offset = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
 
-        if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+        if(!ipsRead(&reader, buffer, 2)) break;
 
         u32 patchSize = (buffer[0] << 8) | buffer[1];
 
+        //RLE record
         if(!patchSize)
         {
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+            if(!ipsRead(&reader, buffer, 3)) break;
 
             u32 rleSize = (buffer[0] << 8) | buffer[1];
 
             if(offset + rleSize > size) break;
 
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 1)) || total != 1) break;
-
-            for(u32 i = 0; i < rleSize; i++)
-                code[offset + i] = buffer[0];
+            memset(code + offset, buffer[2], rleSize);
 
             continue;
         }
 
-        if(offset + patchSize > size) break;
-
-        if(R_FAILED(IFile_Read(&file, &total, code + offset, patchSize)) || total != patchSize) break;
+        if(offset + patchSize > size || !ipsRead(&reader, code + offset, patchSize)) break;
     }
 
 exit:
@@ -481,7 +538,122 @@ exit:
     return ret;
 }
 
-static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
+//Offsets resolved by patchLayeredFs, kept around so that relaunching a title doesn't need another signature scan
+typedef struct LayeredFsPlan
+{
+    u64 progId;
+    u16 progVer;
+    u32 textSize, roSize, dataSize;
+    u32 fsMountArchive, fsRegisterArchive, fsTryOpenFile, fsOpenFileDirectly;
+    u32 payloadOffset, pathOffset, pathAddress, updateRomFsIndex, updateRomFsOffset;
+    u32 hash;
+} LayeredFsPlan;
+
+#define LAYEREDFS_PLAN_CACHE_SIZE 8
+
+static LayeredFsPlan layeredFsPlanCache[LAYEREDFS_PLAN_CACHE_SIZE];
+static u32 layeredFsPlanCacheNext = 0;
+
+static const char *updateRomFsMounts[] = { "rom2:",
+                                           "rex:",
+                                           "patch:",
+                                           "ext:",
+                                           "rom:" };
+
+#define LAYEREDFS_PATH_SIZE (3 + sizeof("/luma/titles/0000000000000000/romfs"))
+
+static u32 hashBytes(u32 hash, const u8 *bytes, u32 size)
+{
+    for(u32 i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619;
+
+    return hash;
+}
+
+//FNV-1a of every byte the plan relies on: the hooked and called functions, where the payload and the path go, and
+//the update RomFS mount name. code.bin, code.ips or code.bps can't change those without the hash changing,
+//and hashing them is much cheaper than going over the whole code
+static u32 computeLayeredFsPlanHash(const LayeredFsPlan *plan, const u8 *code)
+{
+    u32 hash = 2166136261;
+
+    hash = hashBytes(hash, code + plan->fsMountArchive, 4);
+    hash = hashBytes(hash, code + plan->fsRegisterArchive, 4);
+    hash = hashBytes(hash, code + plan->fsTryOpenFile, 4);
+    hash = hashBytes(hash, code + plan->fsOpenFileDirectly, 4);
+    hash = hashBytes(hash, code + plan->payloadOffset, romfsRedirPatchSize);
+    hash = hashBytes(hash, code + plan->pathOffset, LAYEREDFS_PATH_SIZE);
+
+    if(plan->updateRomFsIndex < sizeof(updateRomFsMounts) / sizeof(char *) - 1)
+        hash = hashBytes(hash, code + plan->updateRomFsOffset, strlen(updateRomFsMounts[plan->updateRomFsIndex]) + 1);
+
+    return hash;
+}
+
+static inline LayeredFsPlan *findLayeredFsPlan(u64 progId, u16 progVer, const u8 *code, u32 textSize, u32 roSize, u32 dataSize)
+{
+    for(u32 i = 0; i < LAYEREDFS_PLAN_CACHE_SIZE; i++)
+    {
+        LayeredFsPlan *plan = &layeredFsPlanCache[i];
+
+        if(plan->progId != progId || plan->progVer != progVer || plan->textSize != textSize ||
+           plan->roSize != roSize || plan->dataSize != dataSize) continue;
+
+        //The code may have changed through code.bin, code.ips or code.bps: drop the plan if what it relies on isn't the same
+        if(computeLayeredFsPlanHash(plan, code) != plan->hash)
+        {
+            plan->progId = 0;
+            return NULL;
+        }
+
+        return plan;
+    }
+
+    return NULL;
+}
+
+static inline bool planLayeredFs(LayeredFsPlan *plan, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
+{
+    plan->fsMountArchive = 0xFFFFFFFF;
+    plan->fsRegisterArchive = 0xFFFFFFFF;
+    plan->fsTryOpenFile = 0xFFFFFFFF;
+    plan->fsOpenFileDirectly = 0xFFFFFFFF;
+    plan->payloadOffset = 0;
+    plan->pathOffset = 0;
+    plan->pathAddress = 0xDEADCAFE;
+
+    if(!findLayeredFsSymbols(code, textSize, &plan->fsMountArchive, &plan->fsRegisterArchive, &plan->fsTryOpenFile, &plan->fsOpenFileDirectly) ||
+       !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &plan->payloadOffset, &plan->pathOffset, &plan->pathAddress)) return false;
+
+    u8 temp[sizeof(updateRomFsMounts) / sizeof(char *) - 1][7];
+    MemsearchPattern patterns[sizeof(updateRomFsMounts) / sizeof(char *) - 1];
+
+    //Locate update RomFSes, all candidates are looked for in a single pass and the first one in order of preference wins
+    for(u32 i = 0; i < sizeof(patterns) / sizeof(MemsearchPattern); i++)
+    {
+        u32 patternSize = strlen(updateRomFsMounts[i]);
+        temp[i][0] = 0;
+        memcpy(temp[i] + 1, updateRomFsMounts[i], patternSize);
+        patterns[i].pattern = temp[i];
+        patterns[i].size = patternSize + 1;
+    }
+
+    memsearchMulti(code, size, patterns, sizeof(patterns) / sizeof(MemsearchPattern));
+
+    plan->updateRomFsOffset = 0;
+    for(plan->updateRomFsIndex = 0; plan->updateRomFsIndex < sizeof(patterns) / sizeof(MemsearchPattern); plan->updateRomFsIndex++)
+    {
+        if(patterns[plan->updateRomFsIndex].result != NULL)
+        {
+            plan->updateRomFsOffset = patterns[plan->updateRomFsIndex].result - code;
+            break;
+        }
+    }
+
+    return true;
+}
+
+static inline bool patchLayeredFs(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
 {
     /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/romfs"
        If it exists it should be a folder containing ROMFS files */
@@ -493,34 +665,36 @@ static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize,
 
     if(!archiveId) return true;
 
-    u32 fsMountArchive = 0xFFFFFFFF,
-        fsRegisterArchive = 0xFFFFFFFF,
-        fsTryOpenFile = 0xFFFFFFFF,
-        fsOpenFileDirectly = 0xFFFFFFFF,
-        payloadOffset = 0,
-        pathOffset = 0,
-        pathAddress = 0xDEADCAFE;
-
-    if(!findLayeredFsSymbols(code, textSize, &fsMountArchive, &fsRegisterArchive, &fsTryOpenFile, &fsOpenFileDirectly) ||
-       !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &payloadOffset, &pathOffset, &pathAddress)) return false;
-
-    static const char *updateRomFsMounts[] = { "rom2:",
-                                               "rex:",
-                                               "patch:",
-                                               "ext:",
-                                               "rom:" };
-    u32 updateRomFsIndex;
-
-    //Locate update RomFSes
-    for(updateRomFsIndex = 0; updateRomFsIndex < sizeof(updateRomFsMounts) / sizeof(char *) - 1; updateRomFsIndex++)
+    //Reuse the offsets found the last time this title was launched with the same code, if any
+    LayeredFsPlan *plan = findLayeredFsPlan(progId, progVer, code, textSize, roSize, dataSize);
+
+    if(plan == NULL)
     {
-        u32 patternSize = strlen(updateRomFsMounts[updateRomFsIndex]);
-        u8 temp[7];
-        temp[0] = 0;
-        memcpy(temp + 1, updateRomFsMounts[updateRomFsIndex], patternSize);
-        if(memsearch(code, temp, size, patternSize + 1) != NULL) break;
+        LayeredFsPlan newPlan;
+
+        if(!planLayeredFs(&newPlan, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) return false;
+
+        newPlan.progId = progId;
+        newPlan.progVer = progVer;
+        newPlan.textSize = textSize;
+        newPlan.roSize = roSize;
+        newPlan.dataSize = dataSize;
+        newPlan.hash = computeLayeredFsPlanHash(&newPlan, code);
+
+        plan = &layeredFsPlanCache[layeredFsPlanCacheNext];
+        layeredFsPlanCacheNext = (layeredFsPlanCacheNext + 1) % LAYEREDFS_PLAN_CACHE_SIZE;
+        *plan = newPlan;
     }
 
+    u32 fsMountArchive = plan->fsMountArchive,
+        fsRegisterArchive = plan->fsRegisterArchive,
+        fsTryOpenFile = plan->fsTryOpenFile,
+        fsOpenFileDirectly = plan->fsOpenFileDirectly,
+        payloadOffset = plan->payloadOffset,
+        pathOffset = plan->pathOffset,
+        pathAddress = plan->pathAddress,
+        updateRomFsIndex = plan->updateRomFsIndex;
+
     //Setup the payload
     u8 *payload = code + payloadOffset;
 
@@ -571,23 +745,27 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
                 break;
         }
 
-        if(applyRegionFreePatch)
-        {
-            static const u8 pattern[] = {
-                0x0A, 0x0C, 0x00, 0x10
-            },
-                            patch[] = {
-                0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
-            };
+        static const u8 pattern[] = {
+            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
+        },
+                        pattern2[] = {
+            0x0A, 0x0C, 0x00, 0x10
+        },
+                        patch[] = {
+            0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
+        };
 
-            //Patch SMDH region check
-            if(!patchMemory(code, textSize,
-                    pattern,
-                    sizeof(pattern), -31,
-                    patch,
-                    sizeof(patch), 1
-                )) goto error;
-        }
+        MemsearchPattern patterns[] = {
+            { pattern2, sizeof(pattern2), NULL },
+            { pattern, sizeof(pattern), NULL }
+        };
+
+        //A pattern missing at first may still be created by an earlier patch, so they're only checked when used
+        if(applyRegionFreePatch) memsearchMulti(code, textSize, patterns, 2);
+        else memsearchMulti(code, textSize, patterns + 1, 1);
+
+        //Patch SMDH region check
+        if(applyRegionFreePatch && !patchMemsearchResult(code, textSize, patterns, 2, -31, patch, sizeof(patch))) goto error;
 
         //Patch SMDH region check for manuals
         u32 i;
@@ -597,22 +775,15 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             if(code32[1] == 0xE1A0000D && (*code32 & 0xFFFFFF00) == 0x0A000000 && (code32[-1] & 0xFFFFFF00) == 0xE1110000)
                 {
                     *code32 = 0xE320F000;
+                    memsearchMultiUpdate(code, textSize, patterns + 1, 1, (u8 *)code32, 4);
                     break;
                 }
         }
 
-        if(i == textSize) goto error;
+        if(i == textSize || patterns[1].result == NULL) goto error;
 
         //Patch DS flashcart whitelist check
-        static const u8 pattern[] = {
-            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
-        };
-
-        u8 *temp = memsearch(code, pattern, textSize, sizeof(pattern));
-
-        if(temp == NULL) goto error;
-
-        u32 additive = findFunctionStart(code, (u32)(temp - code - 1));
+        u32 additive = findFunctionStart(code, (u32)(patterns[1].result - code - 1));
 
         if(additive == 0xFFFFFFFF) goto error;
 
@@ -784,25 +955,18 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             0x00, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1 //mov r0, #0; bx lr
         };
 
+        MemsearchPattern patterns[] = {
+            { pattern, sizeof(pattern), NULL },
+            { pattern2, sizeof(pattern2), NULL },
+            { pattern3, sizeof(pattern3), NULL }
+        };
+
         //Disable CRR0 signature (RSA2048 with SHA256) check and CRO0/CRR0 SHA256 hash checks (section hashes, and hash table)
-        if(!patchMemory(code, textSize,
-                pattern,
-                sizeof(pattern), -9,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern2,
-                sizeof(pattern2), 1,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern3,
-                sizeof(pattern3), -2,
-                patch,
-                sizeof(patch), 1
-            )) goto error;
+        //Each patch can create or destroy a match of the patterns after it, which are then searched for again around it
+        memsearchMulti(code, textSize, patterns, 3);
+        if(!patchMemsearchResult(code, textSize, patterns, 3, -9, patch, sizeof(patch)) ||
+           !patchMemsearchResult(code, textSize, patterns + 1, 2, 1, patch, sizeof(patch)) ||
+           !patchMemsearchResult(code, textSize, patterns + 2, 1, -2, patch, sizeof(patch))) goto error;
     }
 
     else if(progId == 0x0004013000002802LL) //DLP
@@ -876,7 +1040,7 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
             if(loadTitleLocaleConfig(progId, &mask, &regionId, &languageId, &countryId, &stateId))
                 svcKernelSetState(0x10001, ((u32)stateId << 24) | ((u32)countryId << 16) | ((u32)languageId << 8) | ((u32)regionId << 4) | (u32)mask , progId);
-            if(!patchLayeredFs(progId, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
+            if(!patchLayeredFs(progId, progVer, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
         }
     }
 
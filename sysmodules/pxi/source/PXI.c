@@ -8,6 +8,9 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 
 #include "PXI.h"
 
+// Set while the send FIFO empty interrupt is bound, used to sleep instead of spinning when the send FIFO is full
+static Handle sendFIFOEmptyInterruptEvent = 0;
+
 void PXIReset(void)
 {
     REG_PXI_SYNC = 0;
@@ -46,10 +49,27 @@ void PXISendWord(u32 word)
 
 void PXISendBuffer(const u32 *buffer, u32 nbWords)
 {
-    for(; nbWords > 0; nbWords--)
+    while(nbWords > 0)
     {
-        while(REG_PXI_CNT & CNT_SEND_FIFO_FULL_STATUS);
-        REG_PXI_SEND = *buffer++;
+        // Check the FIFO status once per burst: a whole FIFO worth of words can be written when it's empty
+        u16 cnt = REG_PXI_CNT;
+        u32 nb;
+
+        if(cnt & CNT_SEND_FIFO_EMPTY_STATUS)
+            nb = nbWords < PXI_FIFO_DEPTH ? nbWords : PXI_FIFO_DEPTH;
+        else if(!(cnt & CNT_SEND_FIFO_FULL_STATUS))
+            nb = 1;
+        else
+        {
+            // The event can be stale (signaled by a previous transfer); the status is checked again anyway
+            if(sendFIFOEmptyInterruptEvent != 0)
+                svcWaitSynchronization(sendFIFOEmptyInterruptEvent, -1LL);
+            continue;
+        }
+
+        nbWords -= nb;
+        for(; nb > 0; nb--)
+            REG_PXI_SEND = *buffer++;
     }
 }
 
@@ -71,10 +91,22 @@ u32 PXIReceiveWord(void)
 
 void PXIReceiveBuffer(u32 *buffer, u32 nbWords)
 {
-    for(; nbWords > 0; nbWords--)
+    while(nbWords > 0)
     {
-        while(REG_PXI_CNT & CNT_RECEIVE_FIFO_EMPTY_STATUS);
-        *buffer++ = REG_PXI_RECV;
+        // Same as above: a full FIFO can be drained without checking the status in-between
+        u16 cnt = REG_PXI_CNT;
+        u32 nb;
+
+        if(cnt & CNT_RECEIVE_FIFO_FULL_STATUS)
+            nb = nbWords < PXI_FIFO_DEPTH ? nbWords : PXI_FIFO_DEPTH;
+        else if(!(cnt & CNT_RECEIVE_FIFO_EMPTY_STATUS))
+            nb = 1;
+        else
+            continue;
+
+        nbWords -= nb;
+        for(; nb > 0; nb--)
+            *buffer++ = REG_PXI_RECV;
     }
 }
 
@@ -102,6 +134,7 @@ Result bindPXIInterrupts(Handle *syncInterrupt, Handle *receiveFIFONotEmptyInter
             return res;
         }
         REG_PXI_CNT = (REG_PXI_CNT & mask) | CNT_ENABLE_SEND_FIFO_EMPTY_IRQ;
+        sendFIFOEmptyInterruptEvent = *sendFIFOEmptyInterrupt;
     }
 
     if(syncInterrupt != NULL)
@@ -130,6 +163,7 @@ void unbindPXIInterrupts(Handle *syncInterrupt, Handle *receiveFIFONotEmptyInter
     {
         REG_PXI_CNT &= CNT_ENABLE_FIFOs | CNT_ENABLE_RECEIVE_FIFO_NOT_EMPTY_IRQ;
         svcUnbindInterrupt(0x52, *sendFIFOEmptyInterrupt);
+        sendFIFOEmptyInterruptEvent = 0;
     }
     if(syncInterrupt != NULL)
     {
@@ -19,10 +19,12 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
         #define SYNC_ENABLE_SYNC11_IRQ  (1U << 7)
 
 #define REG_PXI_CNT     *(vu16 *)(PXI_REGS_BASE + 4)
+    #define CNT_SEND_FIFO_EMPTY_STATUS              (1U <<  0)
     #define CNT_SEND_FIFO_FULL_STATUS               (1U <<  1)
     #define CNT_ENABLE_SEND_FIFO_EMPTY_IRQ          (1U <<  2)
     #define CNT_CLEAR_SEND_FIFO                     (1U <<  3)
     #define CNT_RECEIVE_FIFO_EMPTY_STATUS           (1U <<  8)
+    #define CNT_RECEIVE_FIFO_FULL_STATUS            (1U <<  9)
     #define CNT_ENABLE_RECEIVE_FIFO_NOT_EMPTY_IRQ   (1U << 10)
     #define CNT_ACKNOWLEDGE_FIFO_ERROR              (1U << 14)
     #define CNT_ENABLE_FIFOs                        (1U << 15)
@@ -30,6 +32,8 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #define REG_PXI_SEND    *(vu32 *)(PXI_REGS_BASE + 8)
 #define REG_PXI_RECV    *(vu32 *)(PXI_REGS_BASE + 12)
 
+#define PXI_FIFO_DEPTH  16 // in words
+
 void PXIReset(void);
 void PXITriggerSync9IRQ(void);
 
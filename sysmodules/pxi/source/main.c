@@ -14,6 +14,7 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #include "sender.h"
 
 Handle PXISyncInterrupt = 0, PXITransferMutex = 0;
+static Handle PXISendFIFOEmptyInterrupt = 0;
 Handle terminationRequestedEvent = 0;
 bool shouldTerminate = false;
 SessionManager sessionManager = {0};
@@ -54,9 +55,11 @@ static inline void initPXI(void)
     if(PXITransferMutex != 0) svcBreak(USERBREAK_PANIC); //0xE0A0183B
     assertSuccess(svcCreateMutex(&PXITransferMutex, false));
 
+    // The send FIFO empty interrupt stays bound afterwards, PXISendBuffer waits on it when the FIFO is full
     assertSuccess(svcCreateEvent(&handles[0], RESET_ONESHOT)); //receive FIFO not empty
-    assertSuccess(svcCreateEvent(&handles[1], RESET_ONESHOT)); //send FIFO empty
-    assertSuccess(bindPXIInterrupts(&PXISyncInterrupt, &handles[0], &handles[1]));
+    assertSuccess(svcCreateEvent(&PXISendFIFOEmptyInterrupt, RESET_ONESHOT)); //send FIFO empty
+    handles[1] = PXISendFIFOEmptyInterrupt;
+    assertSuccess(bindPXIInterrupts(&PXISyncInterrupt, &handles[0], &PXISendFIFOEmptyInterrupt));
 
     s32 handleIndex;
     do
@@ -72,7 +75,7 @@ static inline void initPXI(void)
 
 
 
-    unbindPXIInterrupts(NULL, &handles[0], &handles[1]);
+    unbindPXIInterrupts(NULL, &handles[0], NULL);
 
     PXISendByte(1);
     while(PXIReceiveByte() < 1);
@@ -84,12 +87,12 @@ static inline void initPXI(void)
     while(PXIReceiveByte() < 2);
 
     svcCloseHandle(handles[0]);
-    svcCloseHandle(handles[1]);
 }
 
 static inline void exitPXI(void)
 {
-    unbindPXIInterrupts(&PXISyncInterrupt, NULL, NULL);
+    unbindPXIInterrupts(&PXISyncInterrupt, NULL, &PXISendFIFOEmptyInterrupt);
+    svcCloseHandle(PXISendFIFOEmptyInterrupt);
     svcCloseHandle(PXITransferMutex);
     svcCloseHandle(PXISyncInterrupt);
     PXIReset();
@@ -12,9 +12,8 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #include "sender.h"
 #include "PXI.h"
 
-Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
+static Result lockPXITransfer(Handle *additionalHandle)
 {
-
     Result res = 0;
 
     if(additionalHandle != NULL)
@@ -38,9 +37,24 @@ Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
     else
         assertSuccess(svcWaitSynchronization(PXITransferMutex, -1LL));
 
+    return 0;
+}
+
+// PXITransferMutex must be held
+static void doSendPXICmdbuf(u32 serviceId, u32 *buffer)
+{
     PXISendWord(serviceId & 0xFF);
     PXITriggerSync9IRQ(); //notify arm9
     PXISendBuffer(buffer, (buffer[0] & 0x3F) + ((buffer[0] & 0xFC0) >> 6) + 1);
+}
+
+Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
+{
+    Result res = lockPXITransfer(additionalHandle);
+    if(R_FAILED(res))
+        return res;
+
+    doSendPXICmdbuf(serviceId, buffer);
 
     svcReleaseMutex(PXITransferMutex);
     return 0;
@@ -103,6 +117,8 @@ void sender(void)
     {
         if(replyTarget == 0) //send to arm9
         {
+            // Send all the pending commands in one go, taking the transfer mutex only once
+            bool transferLocked = false;
             for(u32 i = 0; i < 9; i++)
             {
                 SessionData *data = &sessionManager.sessionData[i];
@@ -118,15 +134,22 @@ void sender(void)
                 else
                     sessionManager.pendingArm9Commands++;
 
+                if(!transferLocked)
+                {
+                    res = lockPXITransfer(&terminationRequestedEvent);
+                    if(R_FAILED(res))
+                        goto terminate;
+                    transferLocked = true;
+                }
+
                 RecursiveLock_Lock(&data->lock);
                 data->state = STATE_SENT_TO_ARM9;
-                res = sendPXICmdbuf(&terminationRequestedEvent, i, data->buffer);
+                doSendPXICmdbuf(i, data->buffer);
                 RecursiveLock_Unlock(&data->lock);
-
-                if(R_FAILED(res))
-                    goto terminate;
-
             }
+
+            if(transferLocked)
+                svcReleaseMutex(PXITransferMutex);
             cmdbuf[0] = 0xFFFF0000; //Kernel11
         }
 
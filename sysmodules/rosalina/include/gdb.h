@@ -15,6 +15,7 @@
 #include "sock_util.h"
 #include "memory.h"
 #include "ifile.h"
+#include "MyThread.h"
 
 #define MAX_DEBUG           3
 #define MAX_DEBUG_THREAD    127
@@ -27,6 +28,12 @@
 // 1024 is fine enough to put all regs in the 'T' stop reply packets
 #define GDB_BUF_LEN 1024
 
+// Size of the per-context packet buffer (advertised as PacketSize), allocated along with the server
+// (see gdb/server.c). Memory reads and writes, which dominate transfers, are handled in place in that
+// buffer so that they aren't limited by GDB_BUF_LEN. The 4 extra bytes for $#<checksum> make it 4 pages.
+#define GDB_PACKET_BUF_LEN      (0x4000 - 4)
+#define GDB_CONTEXT_MEMORY_BASE 0x0E000000
+
 #define GDB_HANDLER(name)           GDB_Handle##name
 #define GDB_QUERY_HANDLER(name)     GDB_HANDLER(Query##name)
 #define GDB_VERBOSE_HANDLER(name)   GDB_HANDLER(Verbose##name)
@@ -124,6 +131,9 @@ typedef struct GDBContext
     Handle processAttachedEvent, continuedEvent;
     Handle eventToWaitFor;
 
+    MyThread worker;
+    Handle workerEvent, workerSyncedEvent; // see gdb/worker.h
+
     bool multiprocessExtEnabled;
     bool catchThreadEvents;
     bool processEnded, processExited;
@@ -147,7 +157,8 @@ typedef struct GDBContext
     bool enableExternalMemoryAccess;
     char *commandData, *commandEnd;
     int latestSentPacketSize;
-    char buffer[GDB_BUF_LEN + 4];
+    char *buffer; // GDB_PACKET_BUF_LEN + 4 bytes
+    u8 *searchBuffer; // GDB_SEARCH_BUF_LEN bytes
 
     char threadListData[0x800];
     u32 threadListDataPos;
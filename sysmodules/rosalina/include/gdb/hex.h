@@ -0,0 +1,16 @@
+/*
+*   This file is part of Luma3DS.
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   SPDX-License-Identifier: (MIT OR GPL-2.0-or-later)
+*/
+
+#pragma once
+
+#include <3ds/types.h>
+
+u8 GDB_ComputeChecksum(const char *packetData, u32 len);
+void GDB_EncodeHex(char *dst, const void *src, u32 len);
+u32 GDB_DecodeHex(void *dst, const char *src, u32 len);
+u32 GDB_EscapeBinaryData(u32 *encodedCount, void *dst, const void *src, u32 len, u32 maxLen);
+u32 GDB_UnescapeBinaryData(void *dst, const void *src, u32 len);
@@ -9,6 +9,17 @@
 
 #include "gdb.h"
 
+// Memory searches read the target in windows large enough that each read of the heap is a single
+// svcReadProcessMemory call. Each context has its own search buffer (see gdb/server.c): the end of the
+// previous window goes in front of the current one so that matches spanning both are found, and the
+// matches of qSearch:memory:all are kept after the window.
+#define GDB_SEARCH_WINDOW_SIZE  0x10000
+#define GDB_SEARCH_CARRY_SIZE   0x1000 // more than the longest pattern
+#define GDB_SEARCH_MAX_MATCHES  ((GDB_PACKET_BUF_LEN - 9) / 9) // each match takes at most 9 characters of the reply
+#define GDB_SEARCH_BUF_LEN      (GDB_SEARCH_CARRY_SIZE + GDB_SEARCH_WINDOW_SIZE + ((4 * GDB_SEARCH_MAX_MATCHES + 0xFFF) & ~0xFFF))
+
+_Static_assert(GDB_BUF_LEN < GDB_SEARCH_CARRY_SIZE, "Patterns must fit in front of the search window");
+
 Result GDB_ReadTargetMemoryInPage(void *out, GDBContext *ctx, u32 addr, u32 len);
 Result GDB_WriteTargetMemoryInPage(GDBContext *ctx, const void *in, u32 addr, u32 len);
 u32 GDB_ReadTargetMemory(void *out, GDBContext *ctx, u32 addr, u32 len);
@@ -16,9 +27,10 @@ u32 GDB_WriteTargetMemory(GDBContext *ctx, const void *in, u32 addr, u32 len);
 
 int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len);
 int GDB_WriteMemory(GDBContext *ctx, const void *buf, u32 addr, u32 len);
-u32 GDB_SearchMemory(bool *found, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen);
+u32 GDB_SearchMemory(u32 *matches, u32 maxMatches, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen);
 
 GDB_DECLARE_HANDLER(ReadMemory);
+GDB_DECLARE_HANDLER(ReadMemoryRaw);
 GDB_DECLARE_HANDLER(WriteMemory);
 GDB_DECLARE_HANDLER(WriteMemoryRaw);
 GDB_DECLARE_QUERY_HANDLER(SearchMemory);
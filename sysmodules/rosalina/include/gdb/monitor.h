@@ -1,13 +0,0 @@
-/*
-*   This file is part of Luma3DS.
-*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
-*
-*   SPDX-License-Identifier: (MIT OR GPL-2.0-or-later)
-*/
-
-#pragma once
-
-#include "gdb.h"
-#include "gdb/server.h"
-
-void GDB_RunMonitor(GDBServer *server);
@@ -8,14 +8,10 @@
 #pragma once
 
 #include "gdb.h"
+#include "gdb/hex.h"
 #define _REENT_ONLY
 #include <errno.h>
 
-u8 GDB_ComputeChecksum(const char *packetData, u32 len);
-void GDB_EncodeHex(char *dst, const void *src, u32 len);
-u32 GDB_DecodeHex(void *dst, const char *src, u32 len);
-u32 GDB_EscapeBinaryData(u32 *encodedCount, void *dst, const void *src, u32 len, u32 maxLen);
-u32 GDB_UnescapeBinaryData(void *dst, const void *src, u32 len);
 const char *GDB_ParseIntegerList(u32 *dst, const char *src, u32 nb, char sep, char lastSep, u32 base, bool allowPrefix);
 const char *GDB_ParseHexIntegerList(u32 *dst, const char *src, u32 nb, char lastSep);
 const char *GDB_ParseIntegerList64(u64 *dst, const char *src, u32 nb, char sep, char lastSep, u32 base, bool allowPrefix);
@@ -0,0 +1,16 @@
+/*
+*   This file is part of Luma3DS.
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   SPDX-License-Identifier: (MIT OR GPL-2.0-or-later)
+*/
+
+#pragma once
+
+#include "gdb.h"
+#include "gdb/server.h"
+
+// Each context has its own worker thread, which handles both its client's packets and the debug events
+// of its process, so that a slow context doesn't hold the others back.
+void GDB_RunWorker(GDBServer *server, GDBContext *ctx);
+void GDB_SyncWithWorker(GDBContext *ctx);
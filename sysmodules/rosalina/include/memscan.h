@@ -0,0 +1,74 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+
+#pragma once
+
+#include <3ds/types.h>
+
+// Value scanner used by the cheat finder. This part only works on buffers, reading the target
+// process and storing the candidates is up to the caller.
+
+typedef enum MemScanType
+{
+    MEMSCAN_TYPE_U8 = 0,
+    MEMSCAN_TYPE_U16,
+    MEMSCAN_TYPE_U32,
+    MEMSCAN_TYPE_FLOAT,
+
+    MEMSCAN_TYPE_COUNT,
+} MemScanType;
+
+typedef enum MemScanCompare
+{
+    MEMSCAN_CMP_UNKNOWN = 0,    // Keeps everything, only valid for the first pass
+    MEMSCAN_CMP_EQUAL,          // Equal to the searched value
+    MEMSCAN_CMP_CHANGED,        // The others compare against the previous pass
+    MEMSCAN_CMP_UNCHANGED,
+    MEMSCAN_CMP_INCREASED,
+    MEMSCAN_CMP_DECREASED,
+
+    MEMSCAN_CMP_COUNT,
+} MemScanCompare;
+
+static inline u32 MemScan_TypeSize(MemScanType type)
+{
+    return type == MEMSCAN_TYPE_U8 ? 1 : (type == MEMSCAN_TYPE_U16 ? 2 : 4);
+}
+
+static inline bool MemScan_NeedsPrevious(MemScanCompare cmp)
+{
+    return cmp != MEMSCAN_CMP_UNKNOWN && cmp != MEMSCAN_CMP_EQUAL;
+}
+
+u32 MemScan_Load(const void *p, MemScanType type);
+bool MemScan_Matches(MemScanType type, MemScanCompare cmp, u32 cur, u32 prev, u32 value);
+
+// Bit i of bitmap stands for the i-th value of cur (and prev, which may be NULL when the comparison
+// doesn't need it). count must be a multiple of 32. Clears the bits of values that don't match, and
+// returns how many are left.
+u32 MemScan_FilterBitmap(u32 *bitmap, const void *cur, const void *prev, u32 count, MemScanType type, MemScanCompare cmp, u32 value);
+u32 MemScan_CountBits(const u32 *bitmap, u32 words);
@@ -84,6 +84,7 @@ bool menuCheckN3ds(void);
 u32 menuCountItems(const Menu *menu);
 
 MyThread *menuCreateThread(void);
+bool    menuIsOpen(void);
 void    menuEnter(void);
 void    menuLeave(void);
 void    menuThreadMain(void);
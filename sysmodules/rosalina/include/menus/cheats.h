@@ -29,9 +29,10 @@
 #pragma once
 
 #include <3ds/types.h>
+#include "MyThread.h"
 
 #define CHEATS_PER_MENU_PAGE 18
 
 void RosalinaMenu_Cheats(void);
 void Cheat_SeedRng(u64 seed);
-void Cheat_ApplyCheats(void);
+MyThread *cheatCreateThread(void);
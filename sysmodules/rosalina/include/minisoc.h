@@ -42,6 +42,7 @@ long socGethostid(void);
 
 ssize_t socRecvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
 ssize_t socSendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
+ssize_t socSendAll(int sockfd, const void *buf, size_t len, int flags);
 
 static inline ssize_t socRecv(int sockfd, void *buf, size_t len, int flags)
 {
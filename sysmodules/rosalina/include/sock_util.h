@@ -36,6 +36,7 @@ typedef struct sock_ctx
 {
     enum socket_type type;
     bool should_close;
+    bool busy; // data is being handled on another thread, which will clear this
     int sockfd;
     struct sockaddr_in addr_in;
     struct sock_ctx *serv;
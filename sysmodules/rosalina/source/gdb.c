@@ -24,6 +24,8 @@ void GDB_InitializeContext(GDBContext *ctx)
 
     svcCreateEvent(&ctx->continuedEvent, RESET_ONESHOT);
     svcCreateEvent(&ctx->processAttachedEvent, RESET_STICKY);
+    svcCreateEvent(&ctx->workerEvent, RESET_ONESHOT);
+    svcCreateEvent(&ctx->workerSyncedEvent, RESET_STICKY);
 
     ctx->eventToWaitFor = ctx->processAttachedEvent;
     ctx->continueFlags = (DebugFlags)(DBG_SIGNAL_FAULT_EXCEPTION_EVENTS | DBG_INHIBIT_USER_CPU_EXCEPTION_HANDLERS);
@@ -39,6 +41,8 @@ void GDB_FinalizeContext(GDBContext *ctx)
 
     svcCloseHandle(ctx->processAttachedEvent);
     svcCloseHandle(ctx->continuedEvent);
+    svcCloseHandle(ctx->workerEvent);
+    svcCloseHandle(ctx->workerSyncedEvent);
 
     RecursiveLock_Unlock(&ctx->lock);
 }
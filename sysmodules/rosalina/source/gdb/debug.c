@@ -14,6 +14,7 @@
 #include "gdb/mem.h"
 #include "gdb/hio.h"
 #include "gdb/watchpoints.h"
+#include "gdb/worker.h"
 #include "fmt.h"
 
 #include <stdlib.h>
@@ -28,12 +29,9 @@ static void GDB_DetachImmediatelyExtended(GDBContext *ctx)
 
     svcClearEvent(ctx->processAttachedEvent);
     ctx->eventToWaitFor = ctx->processAttachedEvent;
-
-    svcClearEvent(ctx->parent->statusUpdateReceived);
-    svcSignalEvent(ctx->parent->statusUpdated);
     RecursiveLock_Unlock(&ctx->lock);
 
-    svcWaitSynchronization(ctx->parent->statusUpdateReceived, -1LL);
+    GDB_SyncWithWorker(ctx);
 
     RecursiveLock_Lock(&ctx->lock);
     GDB_DetachFromProcess(ctx);
@@ -0,0 +1,133 @@
+/*
+*   This file is part of Luma3DS.
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   SPDX-License-Identifier: (MIT OR GPL-2.0-or-later)
+*/
+
+// Packet encoding helpers. They don't depend on anything else, so that the host tests (see tests/) can build them.
+
+#include "gdb/hex.h"
+#include <string.h>
+
+#define HEX_DIGIT(n)    ((n) < 10 ? '0' + (n) : 'a' + (n) - 10)
+#define HEX_PAIR(b)     (u16)(HEX_DIGIT((b) >> 4) | (HEX_DIGIT((b) & 0xF) << 8))
+#define HEX_PAIRS4(b)   HEX_PAIR(b), HEX_PAIR((b) + 1), HEX_PAIR((b) + 2), HEX_PAIR((b) + 3)
+#define HEX_PAIRS16(b)  HEX_PAIRS4(b), HEX_PAIRS4((b) + 4), HEX_PAIRS4((b) + 8), HEX_PAIRS4((b) + 12)
+#define HEX_PAIRS64(b)  HEX_PAIRS16(b), HEX_PAIRS16((b) + 16), HEX_PAIRS16((b) + 32), HEX_PAIRS16((b) + 48)
+
+// Both characters of each byte, in memory order
+static const u16 hexPairs[256] = { HEX_PAIRS64(0), HEX_PAIRS64(64), HEX_PAIRS64(128), HEX_PAIRS64(192) };
+
+// -1 for anything that isn't a hex digit, NUL included
+static const s8 hexDigitValues[256] = {
+    [0 ... '0' - 1] = -1,
+    ['0'] = 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+    ['9' + 1 ... 'A' - 1] = -1,
+    ['A'] = 10, 11, 12, 13, 14, 15,
+    ['F' + 1 ... 'a' - 1] = -1,
+    ['a'] = 10, 11, 12, 13, 14, 15,
+    ['f' + 1 ... 255] = -1,
+};
+
+u8 GDB_ComputeChecksum(const char *packetData, u32 len)
+{
+    const u8 *data = (const u8 *)packetData;
+    u32 cksum = 0;
+
+    for(; len > 0 && ((uintptr_t)data & 3) != 0; len--)
+        cksum += *data++;
+
+    // Sum the bytes of each word in two 16-bit lanes, which can take 128 words before overflowing
+    while(len >= 4)
+    {
+        u32 nbWords = len / 4 > 128 ? 128 : len / 4;
+        u32 lanes = 0;
+        for(u32 i = 0; i < nbWords; i++)
+        {
+            u32 word = ((const u32 *)data)[i];
+            lanes += (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+        }
+
+        cksum += (lanes & 0xFFFF) + (lanes >> 16);
+        data += 4 * nbWords;
+        len -= 4 * nbWords;
+    }
+
+    for(; len > 0; len--)
+        cksum += *data++;
+
+    return (u8)cksum;
+}
+
+void GDB_EncodeHex(char *dst, const void *src, u32 len)
+{
+    const u8 *src8 = (u8 *)src;
+
+    for(u32 i = 0; i < len; i++)
+        memcpy(dst + 2 * i, &hexPairs[src8[i]], 2);
+}
+
+u32 GDB_DecodeHex(void *dst, const char *src, u32 len)
+{
+    u8 *dst8 = (u8 *)dst;
+    const u8 *src8 = (const u8 *)src;
+    u32 i;
+
+    // Stops at the first pair that isn't made of two hex digits, without reading past a NUL
+    for(i = 0; i < len; i++)
+    {
+        s32 hi = hexDigitValues[src8[2 * i]];
+        if(hi < 0)
+            break;
+        s32 lo = hexDigitValues[src8[2 * i + 1]];
+        if(lo < 0)
+            break;
+
+        dst8[i] = (u8)((hi << 4) | lo);
+    }
+
+    return i;
+}
+
+u32 GDB_EscapeBinaryData(u32 *encodedCount, void *dst, const void *src, u32 len, u32 maxLen)
+{
+    u8 *dst8 = (u8 *)dst;
+    const u8 *src8 = (const u8 *)src;
+
+    // maxLen bounds the output, which can be up to twice as long as the input
+    while((uintptr_t)src8 < (uintptr_t)src + len && (uintptr_t)dst8 < (uintptr_t)dst + maxLen)
+    {
+        if(*src8 == '$' || *src8 == '#' || *src8 == '}' || *src8 == '*')
+        {
+            if ((uintptr_t)dst8 + 1 >= (uintptr_t)dst + maxLen)
+                break;
+            *dst8++ = '}';
+            *dst8++ = *src8++ ^ 0x20;
+        }
+        else
+            *dst8++ = *src8++;
+    }
+
+    *encodedCount = dst8 - (u8 *)dst;
+    return src8 - (u8 *)src;
+}
+
+u32 GDB_UnescapeBinaryData(void *dst, const void *src, u32 len)
+{
+    u8 *dst8 = (u8 *)dst;
+    const u8 *src8 = (const u8 *)src;
+
+    while((uintptr_t)src8 < (uintptr_t)src + len)
+    {
+        if(*src8 == '}')
+        {
+            src8++;
+            *dst8++ = *src8++ ^ 0x20;
+        }
+        else
+            *dst8++ = *src8++;
+    }
+
+    return dst8 - (u8 *)dst;
+}
@@ -8,6 +8,7 @@
 #include "gdb/mem.h"
 #include "gdb/net.h"
 #include "utils.h"
+#include "fmt.h"
 
 static void *k_memcpy_no_interrupt(void *dst, const void *src, u32 len)
 {
@@ -165,24 +166,32 @@ u32 GDB_WriteTargetMemory(GDBContext *ctx, const void *in, u32 addr, u32 len)
 
 int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len)
 {
-    char buf[GDB_BUF_LEN];
-    u8 membuf[GDB_BUF_LEN / 2];
-
-    if(prefix != NULL)
-        memcpy(buf, prefix, prefixLen);
-    else
+    if(prefix == NULL)
         prefixLen = 0;
 
-    if(prefixLen + 2 * len > GDB_BUF_LEN) // gdb shouldn't send requests which responses don't fit in a packet
-        return prefix == NULL ? GDB_ReplyErrno(ctx, ENOMEM) : -1;
+    if(4 + prefixLen + 2 * len > GDB_PACKET_BUF_LEN)
+    {
+        if(prefix != NULL)
+            return -1;
+
+        // Replies to 'm' may be shorter than requested, GDB will ask for the rest
+        len = (GDB_PACKET_BUF_LEN - 4) / 2;
+    }
+
+    // Read the memory into the second half of the packet buffer, and hex-encode it in place: each byte
+    // is consumed before the output reaches it
+    char *out = ctx->buffer + 1;
+    u8 *membuf = (u8 *)out + prefixLen + len;
 
     u32 total = GDB_ReadTargetMemory(membuf, ctx, addr, len);
     if(total == 0)
         return prefix == NULL ? GDB_ReplyErrno(ctx, EFAULT) : -EFAULT;
     else
     {
-        GDB_EncodeHex(buf + prefixLen, membuf, total);
-        return GDB_SendPacket(ctx, buf, prefixLen + 2 * total);
+        if(prefix != NULL)
+            memcpy(out, prefix, prefixLen);
+        GDB_EncodeHex(out + prefixLen, membuf, total);
+        return GDB_SendPacket(ctx, out, prefixLen + 2 * total);
     }
 }
 
@@ -195,47 +204,81 @@ int GDB_WriteMemory(GDBContext *ctx, const void *buf, u32 addr, u32 len)
         return GDB_ReplyOk(ctx);
 }
 
-u32 GDB_SearchMemory(bool *found, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen)
+static u32 GDB_ReadSearchWindow(u8 *out, GDBContext *ctx, u32 addr, u32 len, u64 userLimit)
 {
-    u8 buf[0x1000 + 0x1000 * ((GDB_BUF_LEN + 0xFFF) / 0x1000)];
-    u32 maxNbPages = 1 + ((GDB_BUF_LEN + 0xFFF) / 0x1000);
-    u32 curAddr = addr;
+    // Everything is mapped most of the time, otherwise find out where the readable part ends
+    if((u64)addr + len <= userLimit && R_SUCCEEDED(svcReadProcessMemory(out, ctx->debug, addr, len)))
+        return len;
 
-    s64 TTBCR;
-    svcGetSystemInfo(&TTBCR, 0x10002, 0);
-    while(curAddr < addr + len)
+    u32 total = 0;
+    while(total < len)
     {
-        u32 nbPages;
-        u32 addrBase = curAddr & ~0xFFF, addrDispl = curAddr & 0xFFF;
+        u32 curAddr = addr + total;
+        u32 nb = (len - total > 0x1000 - (curAddr & 0xFFF)) ? 0x1000 - (curAddr & 0xFFF) : len - total;
 
-        for(nbPages = 0; nbPages < maxNbPages; nbPages++)
+        if(curAddr >= userLimit)
         {
-            if(addr >= (1u << (32 - (u32)TTBCR)))
-            {
-                u32 PA = svcConvertVAToPA((const void *)addr, false);
-                if(PA == 0 || (PA >= 0x10000000 && PA <= 0x18000000))
-                    break;
-            }
-
-            if(R_FAILED(GDB_ReadTargetMemoryInPage(buf + 0x1000 * nbPages, ctx, addrBase + nbPages * 0x1000, 0x1000)))
+            u32 PA = svcConvertVAToPA((const void *)curAddr, false);
+            if(PA == 0 || (PA >= 0x10000000 && PA <= 0x18000000))
                 break;
         }
 
-        u8 *pos = NULL;
-        if(addrDispl + patternLen <= 0x1000 * nbPages)
-            pos = memsearch(buf + addrDispl, pattern, 0x1000 * nbPages - addrDispl, patternLen);
+        if(R_FAILED(GDB_ReadTargetMemoryInPage(out + total, ctx, curAddr, nb)))
+            break;
+        total += nb;
+    }
+
+    return total;
+}
+
+u32 GDB_SearchMemory(u32 *matches, u32 maxMatches, GDBContext *ctx, u32 addr, u32 len, const void *pattern, u32 patternLen)
+{
+    u8 *searchBuffer = ctx->searchBuffer;
+    u32 nbMatches = 0;
+    u32 carry = 0; // bytes from the end of the previous window, at most patternLen - 1
+    u64 curAddr = addr, endAddr = (u64)addr + len;
+
+    if(patternLen == 0 || patternLen > GDB_BUF_LEN || maxMatches == 0)
+        return 0;
+
+    s64 TTBCR;
+    svcGetSystemInfo(&TTBCR, 0x10002, 0);
+    u64 userLimit = 1ULL << (32 - (u32)TTBCR);
+
+    while(curAddr < endAddr && nbMatches < maxMatches)
+    {
+        // Keep the reads page-aligned after the first one
+        u32 windowLen = GDB_SEARCH_WINDOW_SIZE - ((u32)curAddr & 0xFFF);
+        if(windowLen > endAddr - curAddr)
+            windowLen = (u32)(endAddr - curAddr);
+
+        u32 nb = GDB_ReadSearchWindow(searchBuffer + carry, ctx, (u32)curAddr, windowLen, userLimit);
+        if(nb == 0)
+        {
+            // Unreadable page, matches can't span it
+            curAddr = (curAddr & ~0xFFFULL) + 0x1000;
+            carry = 0;
+            continue;
+        }
 
-        if(pos != NULL)
+        u32 total = carry + nb;
+        u32 bufAddr = (u32)curAddr - carry;
+        for(u32 start = 0; start + patternLen <= total && nbMatches < maxMatches; )
         {
-            *found = true;
-            return addrBase + (pos - buf);
+            u8 *pos = memsearch(searchBuffer + start, pattern, total - start, patternLen);
+            if(pos == NULL)
+                break;
+
+            matches[nbMatches++] = bufAddr + (pos - searchBuffer);
+            start = pos - searchBuffer + 1;
         }
 
-        curAddr = addrBase + 0x1000;
+        carry = total < patternLen - 1 ? total : patternLen - 1;
+        memmove(searchBuffer, searchBuffer + total - carry, carry);
+        curAddr += nb;
     }
 
-    *found = false;
-    return 0;
+    return nbMatches;
 }
 
 GDB_DECLARE_HANDLER(ReadMemory)
@@ -250,6 +293,32 @@ GDB_DECLARE_HANDLER(ReadMemory)
     return GDB_SendMemory(ctx, NULL, 0, addr, len);
 }
 
+GDB_DECLARE_HANDLER(ReadMemoryRaw)
+{
+    u32 lst[2];
+    if(GDB_ParseHexIntegerList(lst, ctx->commandData, 2, 0) == NULL)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    u32 addr = lst[0];
+    u32 len = lst[1];
+
+    // Same in-place scheme as GDB_SendMemory, escaping needs at most twice the space as well.
+    // Like for 'm', the reply may contain less data than requested.
+    char *out = ctx->buffer + 1;
+    if(2 + 2 * len > GDB_PACKET_BUF_LEN)
+        len = (GDB_PACKET_BUF_LEN - 2) / 2;
+
+    u8 *membuf = (u8 *)out + 1 + len;
+    u32 total = len == 0 ? 0 : GDB_ReadTargetMemory(membuf, ctx, addr, len);
+    if(total == 0 && len != 0)
+        return GDB_ReplyErrno(ctx, EFAULT);
+
+    u32 encodedCount;
+    out[0] = 'b';
+    GDB_EscapeBinaryData(&encodedCount, out + 1, membuf, total, 2 * total);
+    return GDB_SendPacket(ctx, out, 1 + encodedCount);
+}
+
 GDB_DECLARE_HANDLER(WriteMemory)
 {
     u32 lst[2];
@@ -261,10 +330,11 @@ GDB_DECLARE_HANDLER(WriteMemory)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + 2 * len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(dataStart + 2 * len > ctx->commandEnd)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN / 2];
+    // Decode in place, the data can be larger than GDB_BUF_LEN
+    u8 *data = (u8 *)dataStart;
     u32 n = GDB_DecodeHex(data, dataStart, len);
 
     if(n != len)
@@ -284,48 +354,70 @@ GDB_DECLARE_HANDLER(WriteMemoryRaw)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(dataStart + len > ctx->commandEnd)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN];
-    u32 n = GDB_UnescapeBinaryData(data, dataStart, len);
+    // The escaped data is what's left of the packet, and is at least len bytes long
+    u8 *data = (u8 *)dataStart;
+    u32 n = GDB_UnescapeBinaryData(data, dataStart, ctx->commandEnd - dataStart);
 
     if(n != len)
-        return GDB_ReplyErrno(ctx, n);
+        return GDB_ReplyErrno(ctx, EILSEQ);
 
     return GDB_WriteMemory(ctx, data, addr, len);
 }
 
+// qSearch:memory:addr;len;pattern replies with the first match, "1,addr", or "0".
+// qSearch:memory:all:limit;addr;len;pattern replies with up to limit matches, "count,addr1,addr2...".
 GDB_DECLARE_QUERY_HANDLER(SearchMemory)
 {
-    u32 lst[2];
-    u32 addr, len;
-    u8 pattern[GDB_BUF_LEN];
+    u32 lst[3];
+    u32 addr, len, limit = 1;
     const char *patternStart;
     u32 patternLen;
-    bool found;
-    u32 foundAddr;
+    bool all = false;
 
     if(strncmp(ctx->commandData, "memory:", 7) != 0)
         return GDB_ReplyErrno(ctx, EILSEQ);
 
     ctx->commandData += 7;
-    patternStart = GDB_ParseIntegerList(lst, ctx->commandData, 2, ';', ';', 16, false);
+    if(strncmp(ctx->commandData, "all:", 4) == 0)
+    {
+        all = true;
+        ctx->commandData += 4;
+        patternStart = GDB_ParseIntegerList(lst, ctx->commandData, 3, ';', ';', 16, false);
+    }
+    else
+        patternStart = GDB_ParseIntegerList(lst + 1, ctx->commandData, 2, ';', ';', 16, false);
+
     if(patternStart == NULL || *patternStart != ';')
         return GDB_ReplyErrno(ctx, EILSEQ);
 
-    addr = lst[0];
-    len = lst[1];
+    if(all)
+        limit = lst[0] < GDB_SEARCH_MAX_MATCHES ? lst[0] : GDB_SEARCH_MAX_MATCHES;
+    addr = lst[1];
+    len = lst[2];
 
     patternStart++;
     patternLen = ctx->commandEnd - patternStart;
 
+    // Like for X, the pattern is unescaped in place, as it can only shrink
+    u8 *pattern = (u8 *)patternStart;
     patternLen = GDB_UnescapeBinaryData(pattern, patternStart, patternLen);
+    if(patternLen == 0 || patternLen > GDB_BUF_LEN)
+        return GDB_ReplyErrno(ctx, EINVAL);
 
-    foundAddr = GDB_SearchMemory(&found, ctx, addr, len, patternStart, patternLen);
+    u32 *matches = (u32 *)(ctx->searchBuffer + GDB_SEARCH_CARRY_SIZE + GDB_SEARCH_WINDOW_SIZE);
+    u32 nbMatches = GDB_SearchMemory(matches, limit, ctx, addr, len, pattern, patternLen);
 
-    if(found)
-        return GDB_SendFormattedPacket(ctx, "1,%x", foundAddr);
-    else
-        return GDB_SendPacket(ctx, "0", 1);
+    if(!all)
+        return nbMatches != 0 ? GDB_SendFormattedPacket(ctx, "1,%x", matches[0]) : GDB_SendPacket(ctx, "0", 1);
+
+    // The pattern isn't needed anymore, build the reply in place
+    char *buf = ctx->buffer + 1;
+    int n = sprintf(buf, "%lx", nbMatches);
+    for(u32 i = 0; i < nbMatches; i++)
+        n += sprintf(buf + n, ",%lx", matches[i]);
+
+    return GDB_SendPacket(ctx, buf, n);
 }
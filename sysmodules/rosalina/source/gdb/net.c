@@ -11,94 +11,6 @@
 #include "fmt.h"
 #include "minisoc.h"
 
-u8 GDB_ComputeChecksum(const char *packetData, u32 len)
-{
-    u8 cksum = 0;
-    for(u32 i = 0; i < len; i++)
-        cksum += (u8)packetData[i];
-
-    return cksum;
-}
-
-void GDB_EncodeHex(char *dst, const void *src, u32 len)
-{
-    static const char *alphabet = "0123456789abcdef";
-    const u8 *src8 = (u8 *)src;
-
-    for(u32 i = 0; i < len; i++)
-    {
-        dst[2 * i] = alphabet[(src8[i] & 0xf0) >> 4];
-        dst[2 * i + 1] = alphabet[src8[i] & 0x0f];
-    }
-}
-
-static inline u32 GDB_DecodeHexDigit(char src, bool *ok)
-{
-    *ok = true;
-    if(src >= '0' && src <= '9') return src - '0';
-    else if(src >= 'a' && src <= 'f') return 0xA + (src - 'a');
-    else if(src >= 'A' && src <= 'F') return 0xA + (src - 'A');
-    else
-    {
-        *ok = false;
-        return 0;
-    }
-}
-
-u32 GDB_DecodeHex(void *dst, const char *src, u32 len)
-{
-    u32 i = 0;
-    bool ok = true;
-    u8 *dst8 = (u8 *)dst;
-    for(i = 0; i < len && ok && src[2 * i] != 0 && src[2 * i + 1] != 0; i++)
-        dst8[i] = (GDB_DecodeHexDigit(src[2 * i], &ok) << 4) | GDB_DecodeHexDigit(src[2 * i + 1], &ok);
-
-    return (!ok) ? i - 1 : i;
-}
-
-u32 GDB_EscapeBinaryData(u32 *encodedCount, void *dst, const void *src, u32 len, u32 maxLen)
-{
-    u8 *dst8 = (u8 *)dst;
-    const u8 *src8 = (const u8 *)src;
-
-    maxLen = maxLen >= len ? len : maxLen;
-
-    while((uintptr_t)dst8 < (uintptr_t)dst + maxLen)
-    {
-        if(*src8 == '$' || *src8 == '#' || *src8 == '}' || *src8 == '*')
-        {
-            if ((uintptr_t)dst8 + 1 >= (uintptr_t)dst + maxLen)
-                break;
-            *dst8++ = '}';
-            *dst8++ = *src8++ ^ 0x20;
-        }
-        else
-            *dst8++ = *src8++;
-    }
-
-    *encodedCount = dst8 - (u8 *)dst;
-    return src8 - (u8 *)src;
-}
-
-u32 GDB_UnescapeBinaryData(void *dst, const void *src, u32 len)
-{
-    u8 *dst8 = (u8 *)dst;
-    const u8 *src8 = (const u8 *)src;
-
-    while((uintptr_t)src8 < (uintptr_t)src + len)
-    {
-        if(*src8 == '}')
-        {
-            src8++;
-            *dst8++ = *src8++ ^ 0x20;
-        }
-        else
-            *dst8++ = *src8++;
-    }
-
-    return dst8 - (u8 *)dst;
-}
-
 const char *GDB_ParseIntegerList(u32 *dst, const char *src, u32 nb, char sep, char lastSep, u32 base, bool allowPrefix)
 {
     const char *pos = src;
@@ -171,13 +83,65 @@ const char *GDB_ParseHexIntegerList64(u64 *dst, const char *src, u32 nb, char la
     return GDB_ParseIntegerList64(dst, src, nb, ',', lastSep, 16, false);
 }
 
+// How long to wait for the rest of a packet that has only partially arrived
+#define GDB_PACKET_TIMEOUT_MS   2000
+
+// Consumes the first len bytes of a packet that has only partially arrived, then receives the rest of it, up to
+// and including its checksum, without touching what comes after. Returns the position of the '#', or NULL.
+static char *GDB_ReceiveRestOfPacket(GDBContext *ctx, int len)
+{
+    char *buf = ctx->buffer;
+    if(socRecv(ctx->super.sockfd, buf, len, 0) != len)
+        return NULL;
+
+    char *pos = memchr(buf, '#', len);
+    while(pos == NULL || pos + 3 > buf + len)
+    {
+        struct pollfd pfd;
+        pfd.fd = ctx->super.sockfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if(len >= GDB_PACKET_BUF_LEN + 4 || socPoll(&pfd, 1, GDB_PACKET_TIMEOUT_MS) != 1 || !(pfd.revents & POLLIN))
+            return NULL;
+
+        int r = socRecv(ctx->super.sockfd, buf + len, GDB_PACKET_BUF_LEN + 4 - len, MSG_PEEK);
+        if(r < 1)
+            return NULL;
+
+        if(pos == NULL)
+            pos = memchr(buf + len, '#', r);
+        if(pos != NULL && pos + 3 - (buf + len) < r)
+            r = pos + 3 - (buf + len);
+
+        if(socRecv(ctx->super.sockfd, buf + len, r, 0) != r)
+            return NULL;
+        len += r;
+    }
+
+    return pos;
+}
+
 int GDB_ReceivePacket(GDBContext *ctx)
 {
-    char backupbuf[GDB_BUF_LEN + 4];
-    memcpy(backupbuf, ctx->buffer, ctx->latestSentPacketSize);
-    memset(ctx->buffer, 0, sizeof(ctx->buffer));
+    // Look at the first character only, so that the last sent packet is still there if it has to be resent
+    char c;
+    int r = socRecv(ctx->super.sockfd, &c, 1, MSG_PEEK);
+    if(r < 1)
+        return -1;
+    if(c == '-')
+    {
+        r = socRecv(ctx->super.sockfd, &c, 1, 0);
+        if(r != 1)
+            return -1;
+
+        socSendAll(ctx->super.sockfd, ctx->buffer, ctx->latestSentPacketSize, 0);
+        return 0;
+    }
+
+    memset(ctx->buffer, 0, GDB_PACKET_BUF_LEN + 4);
 
-    int r = socRecv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
+    r = socRecv(ctx->super.sockfd, ctx->buffer, GDB_PACKET_BUF_LEN + 4, MSG_PEEK);
     if(r < 1)
         return -1;
     if(ctx->buffer[0] == '+') // GDB sometimes acknowleges TCP acknowledgment packets (yes...). IDA does it properly
@@ -192,38 +156,42 @@ int GDB_ReceivePacket(GDBContext *ctx)
 
         ctx->buffer[0] = 0;
 
-        r = socRecv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
+        r = socRecv(ctx->super.sockfd, ctx->buffer, GDB_PACKET_BUF_LEN + 4, MSG_PEEK);
 
         if(r == -1)
             goto packet_error;
     }
-    else if(ctx->buffer[0] == '-')
-    {
-        socSend(ctx->super.sockfd, backupbuf, ctx->latestSentPacketSize, 0);
-        return 0;
-    }
-    int maxlen = r > (int)sizeof(ctx->buffer) ? (int)sizeof(ctx->buffer) : r;
+    int maxlen = r > GDB_PACKET_BUF_LEN + 4 ? GDB_PACKET_BUF_LEN + 4 : r;
 
     if(ctx->buffer[0] == '$') // normal packet
     {
         char *pos;
         for(pos = ctx->buffer; pos < ctx->buffer + maxlen && *pos != '#'; pos++);
 
-        if(pos == ctx->buffer + maxlen) // malformed packet
-            return -1;
+        u8 checksum;
 
+        // Large packets can span several TCP segments: take what has arrived and wait for the rest (including
+        // the checksum), instead of peeking at the same data over and over
+        if(pos + 3 > ctx->buffer + maxlen)
+        {
+            if(maxlen >= GDB_PACKET_BUF_LEN + 4 || (pos = GDB_ReceiveRestOfPacket(ctx, maxlen)) == NULL)
+                return -1;
+            r = 3 + pos - ctx->buffer;
+        }
         else
         {
-            u8 checksum;
             r = socRecv(ctx->super.sockfd, ctx->buffer, 3 + pos - ctx->buffer, 0);
-            if(r != 3 + pos - ctx->buffer || GDB_DecodeHex(&checksum, pos + 1, 1) != 1)
+            if(r != 3 + pos - ctx->buffer)
                 goto packet_error;
-            else if(GDB_ComputeChecksum(ctx->buffer + 1, pos - ctx->buffer - 1) != checksum)
-                goto packet_error;
-
-            ctx->commandEnd = pos;
-            *pos = 0; // replace trailing '#' by a NUL character
         }
+
+        if(GDB_DecodeHex(&checksum, pos + 1, 1) != 1)
+            goto packet_error;
+        else if(GDB_ComputeChecksum(ctx->buffer + 1, pos - ctx->buffer - 1) != checksum)
+            goto packet_error;
+
+        ctx->commandEnd = pos;
+        *pos = 0; // replace trailing '#' by a NUL character
     }
     else if(ctx->buffer[0] == '\x03')
     {
@@ -264,7 +232,7 @@ packet_error:
 
 static int GDB_DoSendPacket(GDBContext *ctx, u32 len)
 {
-    int r = socSend(ctx->super.sockfd, ctx->buffer, len, 0);
+    int r = socSendAll(ctx->super.sockfd, ctx->buffer, len, 0);
 
     if(r > 0)
         ctx->latestSentPacketSize = r;
@@ -275,12 +243,14 @@ int GDB_SendPacket(GDBContext *ctx, const char *packetData, u32 len)
 {
     ctx->buffer[0] = '$';
 
-    memcpy(ctx->buffer + 1, packetData, len);
+    // packetData may already be in place (see GDB_SendMemory and GDB_SendStreamData)
+    if(packetData != ctx->buffer + 1)
+        memcpy(ctx->buffer + 1, packetData, len);
 
     char *checksumLoc = ctx->buffer + len + 1;
     *checksumLoc++ = '#';
 
-    hexItoa(GDB_ComputeChecksum(packetData, len), checksumLoc, 2, false);
+    hexItoa(GDB_ComputeChecksum(ctx->buffer + 1, len), checksumLoc, 2, false);
     return GDB_DoSendPacket(ctx, 4 + len);
 }
 
@@ -299,7 +269,7 @@ int GDB_SendFormattedPacket(GDBContext *ctx, const char *packetDataFmt, ...)
 
 int GDB_SendHexPacket(GDBContext *ctx, const void *packetData, u32 len)
 {
-    if(4 + 2 * len > GDB_BUF_LEN)
+    if(4 + 2 * len > GDB_PACKET_BUF_LEN)
         return -1;
 
     ctx->buffer[0] = '$';
@@ -314,7 +284,8 @@ int GDB_SendHexPacket(GDBContext *ctx, const void *packetData, u32 len)
 
 int GDB_SendStreamData(GDBContext *ctx, const char *streamData, u32 offset, u32 length, u32 totalSize, bool forceEmptyLast)
 {
-    char buf[GDB_BUF_LEN];
+    // Build the reply directly in the packet buffer
+    char *buf = ctx->buffer + 1;
     if(length > GDB_BUF_LEN - 1)
         length = GDB_BUF_LEN - 1;
 
@@ -108,7 +108,7 @@ GDB_DECLARE_QUERY_HANDLER(Supported)
         "QStartNoAckMode+;QThreadEvents+;QCatchSyscalls+;"
         "vContSupported+;swbreak+;multiprocess+",
 
-        GDB_BUF_LEN // should have been sizeof(ctx->buffer) but GDB memory functions are bugged
+        GDB_PACKET_BUF_LEN
     );
 }
 
@@ -17,8 +17,57 @@
 #include "gdb/watchpoints.h"
 #include "gdb/breakpoints.h"
 #include "gdb/stop_point.h"
+#include "gdb/worker.h"
+#include "csvc.h"
+#include "menu.h"
 #include "task_runner.h"
 
+// Each context gets a block with its packet buffer, followed by its memory search buffer and the stack of its worker
+#define GDB_WORKER_STACK_SIZE       0x4000
+#define GDB_CONTEXT_MEMORY_SIZE     (GDB_PACKET_BUF_LEN + 4 + GDB_SEARCH_BUF_LEN + GDB_WORKER_STACK_SIZE)
+
+static void GDB_FreeContextMemory(GDBServer *server)
+{
+    u32 tmp;
+    for(u32 i = 0; i < MAX_DEBUG; i++)
+    {
+        if(server->ctxs[i].buffer != NULL)
+            svcControlMemory(&tmp, (u32)server->ctxs[i].buffer, 0, GDB_CONTEXT_MEMORY_SIZE, MEMOP_FREE, 0);
+        server->ctxs[i].buffer = NULL;
+        server->ctxs[i].searchBuffer = NULL;
+    }
+}
+
+static Result GDB_AllocateContextMemory(GDBServer *server)
+{
+    Result res = 0;
+    u32 tmp;
+
+    for(u32 i = 0; i < MAX_DEBUG && R_SUCCEEDED(res); i++)
+    {
+        u32 addr = GDB_CONTEXT_MEMORY_BASE + i * GDB_CONTEXT_MEMORY_SIZE;
+        res = svcControlMemoryEx(&tmp, addr, 0, GDB_CONTEXT_MEMORY_SIZE, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true);
+        if(R_SUCCEEDED(res))
+        {
+            server->ctxs[i].buffer = (char *)addr;
+            server->ctxs[i].searchBuffer = (u8 *)addr + GDB_PACKET_BUF_LEN + 4;
+        }
+    }
+
+    if(R_FAILED(res))
+        GDB_FreeContextMemory(server);
+
+    return res;
+}
+
+static int GDB_DispatchPacket(GDBContext *ctx)
+{
+    // The poll thread leaves the socket alone until the worker is done with it
+    ctx->super.busy = true;
+    svcSignalEvent(ctx->workerEvent);
+    return 0;
+}
+
 Result GDB_InitializeServer(GDBServer *server)
 {
     Result ret = server_init(&server->super);
@@ -28,7 +77,7 @@ Result GDB_InitializeServer(GDBServer *server)
     server->super.host = 0;
 
     server->super.accept_cb = (sock_accept_cb)GDB_AcceptClient;
-    server->super.data_cb   = (sock_data_cb)  GDB_DoPacket;
+    server->super.data_cb   = (sock_data_cb)  GDB_DispatchPacket;
     server->super.close_cb  = (sock_close_cb) GDB_CloseClient;
 
     server->super.alloc     = (sock_alloc_func)   GDB_GetClient;
@@ -37,12 +86,19 @@ Result GDB_InitializeServer(GDBServer *server)
     server->super.clients_per_server = 1;
 
     server->referenceCount = 0;
-    svcCreateEvent(&server->statusUpdated, RESET_ONESHOT);
-    svcCreateEvent(&server->statusUpdateReceived, RESET_STICKY);
 
     for(u32 i = 0; i < sizeof(server->ctxs) / sizeof(GDBContext); i++)
         GDB_InitializeContext(server->ctxs + i);
 
+    ret = GDB_AllocateContextMemory(server);
+    if(R_FAILED(ret))
+    {
+        for(u32 i = 0; i < MAX_DEBUG; i++)
+            GDB_FinalizeContext(server->ctxs + i);
+        server_finalize(&server->super);
+        return ret;
+    }
+
     GDB_ResetWatchpoints();
 
     return 0;
@@ -57,8 +113,10 @@ void GDB_FinalizeServer(GDBServer *server)
         if (server->ctxs[i].debug != 0)
             GDB_CloseClient(&server->ctxs[i]);
     }
-    svcCloseHandle(server->statusUpdated);
-    svcCloseHandle(server->statusUpdateReceived);
+    GDB_FreeContextMemory(server);
+
+    for(u32 i = 0; i < MAX_DEBUG; i++)
+        GDB_FinalizeContext(server->ctxs + i);
 }
 
 void GDB_IncrementServerReferenceCount(GDBServer *server)
@@ -72,6 +130,21 @@ void GDB_DecrementServerReferenceCount(GDBServer *server)
         GDB_FinalizeServer(server);
 }
 
+static GDBServer *gdbWorkerServer;
+
+#define GDB_DEFINE_WORKER_ENTRYPOINT(n)\
+static void GDB_WorkerMain##n(void)\
+{\
+    GDB_RunWorker(gdbWorkerServer, &gdbWorkerServer->ctxs[n]);\
+}
+
+GDB_DEFINE_WORKER_ENTRYPOINT(0)
+GDB_DEFINE_WORKER_ENTRYPOINT(1)
+GDB_DEFINE_WORKER_ENTRYPOINT(2)
+
+_Static_assert(MAX_DEBUG == 3, "Update the worker entrypoints");
+static void (*const gdbWorkerEntrypoints[MAX_DEBUG])(void) = { GDB_WorkerMain0, GDB_WorkerMain1, GDB_WorkerMain2 };
+
 void GDB_RunServer(GDBServer *server)
 {
     Result res = server_bind(&server->super, GDB_PORT_BASE);
@@ -80,8 +153,29 @@ void GDB_RunServer(GDBServer *server)
 
     if(R_SUCCEEDED(res)) res = server_bind(&server->super, GDB_PORT_BASE + 3); // next application
 
-    if(R_SUCCEEDED(res))
+    if(R_FAILED(res))
+        return;
+
+    // This thread only polls, everything else is done by the workers
+    gdbWorkerServer = server;
+    server->super.running = true;
+    u32 nbWorkers;
+    for(nbWorkers = 0; nbWorkers < MAX_DEBUG; nbWorkers++)
+    {
+        u8 *stack = server->ctxs[nbWorkers].searchBuffer + GDB_SEARCH_BUF_LEN;
+        if(R_FAILED(MyThread_Create(&server->ctxs[nbWorkers].worker, gdbWorkerEntrypoints[nbWorkers], stack, GDB_WORKER_STACK_SIZE, 0x20, CORE_SYSTEM)))
+            break;
+    }
+
+    // A context without its worker would accept clients and never serve them, so don't serve anything then
+    if(nbWorkers == MAX_DEBUG)
         server_run(&server->super);
+    else
+        server->super.running = false;
+
+    svcSignalEvent(server->super.shall_terminate_event);
+    for(u32 i = 0; i < nbWorkers; i++)
+        MyThread_Join(&server->ctxs[i].worker, -1LL);
 }
 
 void GDB_LockAllContexts(GDBServer *server)
@@ -182,12 +276,9 @@ int GDB_CloseClient(GDBContext *ctx)
     RecursiveLock_Lock(&ctx->lock);
     svcClearEvent(ctx->processAttachedEvent);
     ctx->eventToWaitFor = ctx->processAttachedEvent;
-    svcClearEvent(ctx->parent->statusUpdateReceived);
-    svcSignalEvent(ctx->parent->statusUpdated); // note: monitor will be waiting for lock
     RecursiveLock_Unlock(&ctx->lock);
 
-    if(ctx->parent->referenceCount >= 2)
-        svcWaitSynchronization(ctx->parent->statusUpdateReceived, -1LL);
+    GDB_SyncWithWorker(ctx);
 
     RecursiveLock_Lock(&ctx->lock);
     if (ctx->state >= GDB_STATE_ATTACHED || ctx->debug != 0)
@@ -308,6 +399,7 @@ static const struct
     { 'R', GDB_HANDLER(Restart) },
     { 'T', GDB_HANDLER(IsThreadAlive) },
     { 'v', GDB_HANDLER(VerboseCommand) },
+    { 'x', GDB_HANDLER(ReadMemoryRaw) },
     { 'X', GDB_HANDLER(WriteMemoryRaw) },
     { 'z', GDB_HANDLER(ToggleStopPoint) },
     { 'Z', GDB_HANDLER(ToggleStopPoint) },
@@ -331,7 +423,11 @@ int GDB_DoPacket(GDBContext *ctx)
     u32 oldFlags = ctx->flags;
 
     if(ctx->state == GDB_STATE_DISCONNECTED)
+    {
+        // Packets are handled on the worker, which must not keep the lock
+        RecursiveLock_Unlock(&ctx->lock);
         return -1;
+    }
 
     int r = GDB_ReceivePacket(ctx);
     if(r == 0)
@@ -166,6 +166,7 @@ static int GDB_MakeUtf16Path(FS_Path *outPath, const char *pathData)
 {
     size_t pathDataLen = strlen(pathData);
     if (pathDataLen % 2 == 1) return GDBHIO_EINVAL;
+    else if (pathDataLen / 2 > PATH_MAX) return GDBHIO_ENAMETOOLONG;
 
     char path[PATH_MAX + 1];
     u32 count = GDB_DecodeHex(path, pathData, pathDataLen / 2);
@@ -348,7 +349,6 @@ GDB_DECLARE_TIO_HANDLER(Read)
 
 GDB_DECLARE_TIO_HANDLER(Write)
 {
-    u8 buf[GDB_BUF_LEN];
     u32 args[2];
     const char *comma = GDB_ParseHexIntegerList(args, ctx->commandData, 2, ',');
     if (comma == NULL)
@@ -358,6 +358,8 @@ GDB_DECLARE_TIO_HANDLER(Write)
     u32 offset = args[1];
     const char *escData = comma + 1;
 
+    // Unescape in place, the data can be as large as the packet buffer
+    u8 *buf = (u8 *)escData;
     u32 count = GDB_UnescapeBinaryData(buf, escData, ctx->commandEnd - escData);
 
     GdbTioFileInfo *fi = GDB_TioConvertFd(ctx, fd);
@@ -0,0 +1,135 @@
+/*
+*   This file is part of Luma3DS.
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   SPDX-License-Identifier: (MIT OR GPL-2.0-or-later)
+*/
+
+#include "gdb/worker.h"
+#include "gdb/net.h"
+#include "gdb/debug.h"
+#include "minisoc.h"
+
+extern Handle preTerminationEvent;
+extern bool preTerminationRequested;
+
+// How long a worker keeps waiting for the next packet of its client itself, before handing the
+// socket back to the poll thread (which only notices it on its next poll). Not done while the process
+// is running, as GDB then waits for a stop reply that only the debug events can trigger.
+#define GDB_WORKER_IDLE_TIMEOUT_MS  50
+
+static void GDB_ServeClient(GDBContext *ctx)
+{
+    struct pollfd pfd;
+    int r;
+
+    do
+    {
+        if(GDB_DoPacket(ctx) == -1)
+        {
+            ctx->super.should_close = true;
+            break;
+        }
+        else if(ctx->flags & GDB_FLAG_PROCESS_CONTINUING)
+            break;
+
+        pfd.fd = ctx->super.sockfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        r = socPoll(&pfd, 1, GDB_WORKER_IDLE_TIMEOUT_MS);
+    }
+    while(r > 0 && pfd.revents == POLLIN && !preTerminationRequested);
+
+    ctx->super.busy = false;
+}
+
+static void GDB_HandleWorkerEvent(GDBContext *ctx)
+{
+    RecursiveLock_Lock(&ctx->lock);
+    if(ctx->state == GDB_STATE_DISCONNECTED || ctx->state == GDB_STATE_DETACHING)
+    {
+        svcClearEvent(ctx->processAttachedEvent);
+        ctx->eventToWaitFor = ctx->processAttachedEvent;
+        RecursiveLock_Unlock(&ctx->lock);
+        return;
+    }
+
+    if(ctx->eventToWaitFor == ctx->processAttachedEvent)
+        ctx->eventToWaitFor = ctx->continuedEvent;
+    else if(ctx->eventToWaitFor == ctx->continuedEvent)
+        ctx->eventToWaitFor = ctx->debug;
+    else
+    {
+        int res = GDB_HandleDebugEvents(ctx);
+        if(res >= 0)
+            ctx->eventToWaitFor = ctx->continuedEvent;
+        else if(res == -2)
+        {
+            while(GDB_HandleDebugEvents(ctx) != -1) // until we've got all the remaining debug events
+                svcSleepThread(1 * 1000 * 1000LL); // sleep just in case
+
+            // GDB doens't close the socket in extended-remote
+            if (ctx->flags & GDB_FLAG_EXTENDED_REMOTE) {
+                ctx->state = GDB_STATE_DETACHING;
+                GDB_DetachFromProcess(ctx);
+                ctx->flags &= GDB_FLAG_PROC_RESTART_MASK;
+            }
+            svcClearEvent(ctx->processAttachedEvent);
+            ctx->eventToWaitFor = ctx->processAttachedEvent;
+        }
+    }
+
+    RecursiveLock_Unlock(&ctx->lock);
+}
+
+void GDB_RunWorker(GDBServer *server, GDBContext *ctx)
+{
+    Handle handles[4];
+    Result r = 0;
+
+    handles[0] = preTerminationEvent;
+    handles[1] = server->super.shall_terminate_event;
+    handles[2] = ctx->workerEvent;
+
+    do
+    {
+        RecursiveLock_Lock(&ctx->lock);
+        handles[3] = ctx->eventToWaitFor;
+        RecursiveLock_Unlock(&ctx->lock);
+        svcSignalEvent(ctx->workerSyncedEvent);
+
+        s32 idx = -1;
+        r = svcWaitSynchronizationN(&idx, handles, 4, false, -1LL);
+
+        if(R_FAILED(r) || idx < 2)
+            break;
+        else if(idx == 2)
+        {
+            if(ctx->super.busy)
+                GDB_ServeClient(ctx);
+        }
+        else
+            GDB_HandleWorkerEvent(ctx);
+    }
+    while(!preTerminationRequested && server->super.running);
+}
+
+void GDB_SyncWithWorker(GDBContext *ctx)
+{
+    // Makes the worker stop waiting on what eventToWaitFor was before (e.g. a debug handle about to be closed).
+    // Nothing to do from the worker itself, or once it has exited.
+    u32 workerThreadId, threadId;
+    if(ctx->worker.handle == 0 || R_FAILED(svcGetThreadId(&workerThreadId, ctx->worker.handle)))
+        return;
+
+    svcGetThreadId(&threadId, CUR_THREAD_HANDLE);
+    if(threadId == workerThreadId)
+        return;
+
+    Handle handles[2] = { ctx->workerSyncedEvent, ctx->worker.handle };
+    s32 idx;
+
+    svcClearEvent(ctx->workerSyncedEvent);
+    svcSignalEvent(ctx->workerEvent);
+    svcWaitSynchronizationN(&idx, handles, 2, false, -1LL);
+}
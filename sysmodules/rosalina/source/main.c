@@ -274,6 +274,7 @@ int main(void)
     Draw_Init();
     Cheat_SeedRng(svcGetSystemTick());
 
+    MyThread *cheatThread = cheatCreateThread();
     MyThread *menuThread = menuCreateThread();
     MyThread *taskRunnerThread = taskRunnerCreateThread();
     MyThread *errDispThread = errDispCreateThread();
@@ -285,6 +286,7 @@ int main(void)
     TaskRunner_Terminate();
 
     MyThread_Join(menuThread, -1LL);
+    MyThread_Join(cheatThread, -1LL);
 
     MyThread_Join(taskRunnerThread, -1LL);
     MyThread_Join(errDispThread, -1LL);
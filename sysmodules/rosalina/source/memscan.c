@@ -0,0 +1,147 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2020 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "memscan.h"
+
+u32 MemScan_Load(const void *p, MemScanType type)
+{
+    switch(type)
+    {
+        case MEMSCAN_TYPE_U8:
+            return *(const u8 *)p;
+        case MEMSCAN_TYPE_U16:
+            return *(const u16 *)p;
+        default:
+            return *(const u32 *)p;
+    }
+}
+
+static inline float MemScan_AsFloat(u32 bits)
+{
+    union { u32 u; float f; } v = { .u = bits };
+    return v.f;
+}
+
+bool MemScan_Matches(MemScanType type, MemScanCompare cmp, u32 cur, u32 prev, u32 value)
+{
+    //Floats are only ordered as floats, equality is on the bit pattern
+    if(type == MEMSCAN_TYPE_FLOAT && (cmp == MEMSCAN_CMP_INCREASED || cmp == MEMSCAN_CMP_DECREASED))
+    {
+        float c = MemScan_AsFloat(cur), p = MemScan_AsFloat(prev);
+        return cmp == MEMSCAN_CMP_INCREASED ? c > p : c < p;
+    }
+
+    switch(cmp)
+    {
+        case MEMSCAN_CMP_EQUAL:
+            return cur == value;
+        case MEMSCAN_CMP_CHANGED:
+            return cur != prev;
+        case MEMSCAN_CMP_UNCHANGED:
+            return cur == prev;
+        case MEMSCAN_CMP_INCREASED:
+            return cur > prev;
+        case MEMSCAN_CMP_DECREASED:
+            return cur < prev;
+        default:
+            return true;
+    }
+}
+
+//Only the candidates still set are looked at, so passes get cheaper as the set shrinks and runs
+//of 32 rejected values are skipped with a single test
+#define MEMSCAN_FILTER(T, keep)                                 \
+    for(u32 w = 0; w < count / 32; w++)                         \
+    {                                                           \
+        u32 bits = bitmap[w];                                   \
+        u32 kept = bits;                                        \
+        while(bits != 0)                                        \
+        {                                                       \
+            u32 bit = __builtin_ctz(bits);                      \
+            u32 i = 32 * w + bit;                               \
+            bits &= bits - 1;                                   \
+            if(!(keep))                                         \
+                kept &= ~BIT(bit);                              \
+        }                                                       \
+        bitmap[w] = kept;                                       \
+        remaining += __builtin_popcount(kept);                  \
+    }
+
+#define MEMSCAN_FILTER_TYPE(T)                                                      \
+    do                                                                              \
+    {                                                                               \
+        const T *c = (const T *)cur;                                                \
+        const T *p = (const T *)prev;                                               \
+        const T v = (T)value;                                                       \
+        switch(cmp)                                                                 \
+        {                                                                           \
+            case MEMSCAN_CMP_EQUAL:     MEMSCAN_FILTER(T, c[i] == v); break;        \
+            case MEMSCAN_CMP_CHANGED:   MEMSCAN_FILTER(T, c[i] != p[i]); break;     \
+            case MEMSCAN_CMP_UNCHANGED: MEMSCAN_FILTER(T, c[i] == p[i]); break;     \
+            case MEMSCAN_CMP_INCREASED: MEMSCAN_FILTER(T, c[i] > p[i]); break;      \
+            case MEMSCAN_CMP_DECREASED: MEMSCAN_FILTER(T, c[i] < p[i]); break;      \
+            default: break;                                                         \
+        }                                                                           \
+    }                                                                               \
+    while(0)
+
+u32 MemScan_FilterBitmap(u32 *bitmap, const void *cur, const void *prev, u32 count, MemScanType type, MemScanCompare cmp, u32 value)
+{
+    u32 remaining = 0;
+
+    if(cmp == MEMSCAN_CMP_UNKNOWN || (MemScan_NeedsPrevious(cmp) && prev == NULL))
+        return MemScan_CountBits(bitmap, count / 32);
+
+    switch(type)
+    {
+        case MEMSCAN_TYPE_U8:
+            MEMSCAN_FILTER_TYPE(u8);
+            break;
+        case MEMSCAN_TYPE_U16:
+            MEMSCAN_FILTER_TYPE(u16);
+            break;
+        case MEMSCAN_TYPE_FLOAT:
+            if(cmp == MEMSCAN_CMP_INCREASED || cmp == MEMSCAN_CMP_DECREASED)
+            {
+                MEMSCAN_FILTER_TYPE(float);
+                break;
+            }
+            //fallthrough
+        default:
+            MEMSCAN_FILTER_TYPE(u32);
+            break;
+    }
+
+    return remaining;
+}
+
+u32 MemScan_CountBits(const u32 *bitmap, u32 words)
+{
+    u32 total = 0;
+    for(u32 i = 0; i < words; i++)
+        total += __builtin_popcount(bitmap[i]);
+    return total;
+}
@@ -254,8 +254,6 @@ void menuThreadMain(void)
         if (menuShouldExit)
             continue;
 
-        Cheat_ApplyCheats();
-
         if(((scanHeldKeys() & menuCombo) == menuCombo) && !g_blockMenuOpen)
         {
             menuEnter();
@@ -273,6 +271,11 @@ void menuThreadMain(void)
 }
 
 static s32 menuRefCount = 0;
+bool menuIsOpen(void)
+{
+    return menuRefCount > 0;
+}
+
 void menuEnter(void)
 {
     Draw_Lock();
@@ -30,6 +30,7 @@
 #include "menu.h"
 #include "draw.h"
 #include "menus/process_list.h"
+#include "menus/cheat_finder.h"
 #include "menus/n3ds.h"
 #include "menus/debugger.h"
 #include "menus/miscellaneous.h"
@@ -49,6 +50,7 @@ Menu rosalinaMenu = {
         { "Cambiar brillo de pantalla", METHOD, .method = &RosalinaMenu_ChangeScreenBrightness },
         { "Trucos...", METHOD, .method = &RosalinaMenu_Cheats },
         { "", METHOD, .method = PluginLoader__MenuCallback},
+        { "Buscador de trucos", METHOD, .method = &RosalinaMenu_CheatFinder },
         { "Lista de procesos", METHOD, .method = &RosalinaMenu_ProcessList },
         { "Opciones del depurador...", MENU, .menu = &debuggerMenu },
         { "Configuracion de sistema...", MENU, .menu = &sysconfigMenu },
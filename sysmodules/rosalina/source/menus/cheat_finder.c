@@ -0,0 +1,477 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2022 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include <3ds.h>
+#include "menus/cheat_finder.h"
+#include "memscan.h"
+#include "draw.h"
+#include "menu.h"
+#include "utils.h"
+#include "ifile.h"
+#include "pmdbgext.h"
+#include "csvc.h"
+
+#define FINDER_CHUNK_SIZE   0x4000
+#define FINDER_MAX_REGIONS  16
+#define FINDER_MAX_RESULTS  1024
+
+// Until there are few enough candidates to be listed, the search state lives on the SD card: the
+// values seen by the last pass, and a bitmap with a bit per aligned value
+#define FINDER_SNAPSHOT_PATH    "/luma/finder_snapshot.bin"
+#define FINDER_BITMAP_PATH      "/luma/finder_bitmap.bin"
+
+typedef struct FinderRegion
+{
+    u32 base;
+    u32 size;
+} FinderRegion;
+
+typedef struct FinderResult
+{
+    u32 address;
+    u32 value;
+} FinderResult;
+
+typedef struct CheatFinder
+{
+    u64 titleId;
+    u32 pid;
+    MemScanType type;
+    MemScanCompare compare;
+    u32 value;
+    u32 passes;
+    u32 candidates;
+    bool listMode;
+    bool regionsTruncated; // More writable blocks than FINDER_MAX_REGIONS, the extra ones aren't searched
+    u32 regionCount;
+    FinderRegion regions[FINDER_MAX_REGIONS];
+} CheatFinder;
+
+static CheatFinder finder = { 0 };
+static u8 ALIGN(4) finderPrevious[FINDER_CHUNK_SIZE];
+static u32 finderBitmap[FINDER_CHUNK_SIZE / 32];
+static FinderResult finderResults[FINDER_MAX_RESULTS];
+static u32 finderWindow = 0;
+
+static const char *finderTypeNames[MEMSCAN_TYPE_COUNT] = { "u8", "u16", "u32", "float" };
+static const char *finderCompareNames[MEMSCAN_CMP_COUNT] = {
+    "desconocido", "igual a", "cambiado", "sin cambios", "aumentado", "disminuido",
+};
+
+static void CheatFinder_Reset(u32 pid, u64 titleId)
+{
+    MemScanType type = finder.titleId == titleId ? finder.type : MEMSCAN_TYPE_U32;
+    memset(&finder, 0, sizeof(finder));
+    finder.pid = pid;
+    finder.titleId = titleId;
+    finder.type = type;
+    finder.compare = MEMSCAN_CMP_UNKNOWN;
+}
+
+static void CheatFinder_FindRegions(Handle processHandle)
+{
+    u32 address = 0x00100000;
+
+    finder.regionCount = 0;
+    finder.regionsTruncated = false;
+    while(address < 0x40000000)
+    {
+        MemInfo info;
+        PageInfo out;
+        if(R_FAILED(svcQueryProcessMemory(&info, &out, processHandle, address)) || info.size == 0)
+            break;
+
+        bool searchable = info.state == MEMSTATE_CODE || info.state == MEMSTATE_PRIVATE ||
+            info.state == MEMSTATE_CONTINUOUS || info.state == MEMSTATE_ALIASCODE;
+        if(searchable && (info.perm & MEMPERM_WRITE))
+        {
+            if(finder.regionCount == FINDER_MAX_REGIONS)
+            {
+                finder.regionsTruncated = true;
+                break;
+            }
+
+            finder.regions[finder.regionCount].base = info.base_addr;
+            finder.regions[finder.regionCount].size = info.size;
+            finder.regionCount++;
+        }
+
+        address = info.base_addr + info.size;
+    }
+}
+
+static void CheatFinder_DrawProgress(u32 done, u32 total)
+{
+    Draw_Lock();
+    Draw_DrawString(10, 10, COLOR_TITLE, "Buscador de trucos");
+    Draw_DrawFormattedString(10, 30, COLOR_WHITE, "Buscando... %3lu%%", (u32)(100ULL * done / (total ? total : 1)));
+    Draw_FlushFramebuffer();
+    Draw_Unlock();
+}
+
+// One pass while the candidates are kept as a bitmap. Chunks whose candidates are all gone are
+// neither mapped nor read again.
+static Result CheatFinder_ScanBitmap(Handle processHandle)
+{
+    IFile snapshot, bitmap;
+    u64 total;
+    Result res;
+    bool first = finder.passes == 0;
+    u32 size = MemScan_TypeSize(finder.type);
+    u32 flags = first ? FS_OPEN_CREATE | FS_OPEN_READ | FS_OPEN_WRITE : FS_OPEN_READ | FS_OPEN_WRITE;
+
+    u32 totalSize = 0;
+    for(u32 i = 0; i < finder.regionCount; i++)
+        totalSize += finder.regions[i].size;
+
+    res = IFile_Open(&snapshot, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, FINDER_SNAPSHOT_PATH), flags);
+    if(R_FAILED(res))
+        return res;
+    res = IFile_Open(&bitmap, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, FINDER_BITMAP_PATH), flags);
+    if(R_FAILED(res))
+    {
+        IFile_Close(&snapshot);
+        return res;
+    }
+
+    u32 remaining = 0;
+    u32 offset = 0;
+    for(u32 i = 0; i < finder.regionCount && R_SUCCEEDED(res); i++)
+    {
+        const FinderRegion *region = &finder.regions[i];
+        for(u32 pos = 0; pos < region->size && R_SUCCEEDED(res); )
+        {
+            u32 chunkSize = region->size - pos < FINDER_CHUNK_SIZE ? region->size - pos : FINDER_CHUNK_SIZE;
+            u32 count = chunkSize / size;
+            u32 bitmapSize = count / 8;
+            u64 bitmapOffset = offset / size / 8;
+
+            if((offset / FINDER_CHUNK_SIZE) % 64 == 0)
+                CheatFinder_DrawProgress(offset, totalSize);
+
+            bool skip = false;
+            if(first)
+                memset(finderBitmap, 0xFF, bitmapSize);
+            else
+            {
+                bitmap.pos = bitmapOffset;
+                res = IFile_Read(&bitmap, &total, finderBitmap, bitmapSize);
+                skip = R_FAILED(res) || MemScan_CountBits(finderBitmap, bitmapSize / 4) == 0;
+            }
+
+            if(!skip)
+            {
+                if(R_SUCCEEDED(svcMapProcessMemoryEx(CUR_PROCESS_HANDLE, finderWindow, processHandle, region->base + pos, chunkSize)))
+                {
+                    if(!first)
+                    {
+                        snapshot.pos = offset;
+                        res = IFile_Read(&snapshot, &total, finderPrevious, chunkSize);
+                    }
+                    if(R_SUCCEEDED(res))
+                    {
+                        remaining += MemScan_FilterBitmap(finderBitmap, (const void *)finderWindow, first ? NULL : finderPrevious,
+                                                          count, finder.type, finder.compare, finder.value);
+                        snapshot.pos = offset;
+                        res = IFile_Write(&snapshot, &total, (const void *)finderWindow, chunkSize, 0);
+                    }
+                    svcUnmapProcessMemoryEx(CUR_PROCESS_HANDLE, finderWindow, chunkSize);
+                }
+                else
+                    memset(finderBitmap, 0, bitmapSize); // The block went away
+
+                if(R_SUCCEEDED(res))
+                {
+                    bitmap.pos = bitmapOffset;
+                    res = IFile_Write(&bitmap, &total, finderBitmap, bitmapSize, 0);
+                }
+            }
+
+            pos += chunkSize;
+            offset += chunkSize;
+        }
+    }
+
+    IFile_Close(&bitmap);
+    IFile_Close(&snapshot);
+
+    if(R_SUCCEEDED(res))
+        finder.candidates = remaining;
+    return res;
+}
+
+// Turns the bitmap into a list of addresses with the values seen by the last pass
+static Result CheatFinder_CollectResults(void)
+{
+    IFile snapshot, bitmap;
+    u64 total;
+    Result res;
+    u32 size = MemScan_TypeSize(finder.type);
+
+    res = IFile_Open(&snapshot, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, FINDER_SNAPSHOT_PATH), FS_OPEN_READ);
+    if(R_FAILED(res))
+        return res;
+    res = IFile_Open(&bitmap, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, FINDER_BITMAP_PATH), FS_OPEN_READ);
+    if(R_FAILED(res))
+    {
+        IFile_Close(&snapshot);
+        return res;
+    }
+
+    u32 count = 0;
+    u32 offset = 0;
+    for(u32 i = 0; i < finder.regionCount && R_SUCCEEDED(res); i++)
+    {
+        const FinderRegion *region = &finder.regions[i];
+        for(u32 pos = 0; pos < region->size && R_SUCCEEDED(res) && count < finder.candidates; )
+        {
+            u32 chunkSize = region->size - pos < FINDER_CHUNK_SIZE ? region->size - pos : FINDER_CHUNK_SIZE;
+            u32 bitmapSize = chunkSize / size / 8;
+
+            bitmap.pos = offset / size / 8;
+            res = IFile_Read(&bitmap, &total, finderBitmap, bitmapSize);
+            if(R_SUCCEEDED(res) && MemScan_CountBits(finderBitmap, bitmapSize / 4) != 0)
+            {
+                snapshot.pos = offset;
+                res = IFile_Read(&snapshot, &total, finderPrevious, chunkSize);
+                for(u32 w = 0; R_SUCCEEDED(res) && w < bitmapSize / 4; w++)
+                {
+                    for(u32 bits = finderBitmap[w]; bits != 0 && count < FINDER_MAX_RESULTS; bits &= bits - 1)
+                    {
+                        u32 index = 32 * w + __builtin_ctz(bits);
+                        finderResults[count].address = region->base + pos + index * size;
+                        finderResults[count].value = MemScan_Load(finderPrevious + index * size, finder.type);
+                        count++;
+                    }
+                }
+            }
+
+            pos += chunkSize;
+            offset += chunkSize;
+        }
+    }
+
+    IFile_Close(&bitmap);
+    IFile_Close(&snapshot);
+
+    if(R_SUCCEEDED(res))
+    {
+        finder.candidates = count;
+        finder.listMode = true;
+    }
+    return res;
+}
+
+static void CheatFinder_ScanList(Handle processHandle)
+{
+    u32 mappedPage = 0;
+    bool mapped = false;
+    u32 kept = 0;
+
+    for(u32 i = 0; i < finder.candidates; i++)
+    {
+        u32 address = finderResults[i].address;
+        if(!mapped || (address & ~0xFFF) != mappedPage)
+        {
+            if(mapped)
+                svcUnmapProcessMemoryEx(CUR_PROCESS_HANDLE, finderWindow, 0x1000);
+            mappedPage = address & ~0xFFF;
+            mapped = R_SUCCEEDED(svcMapProcessMemoryEx(CUR_PROCESS_HANDLE, finderWindow, processHandle, mappedPage, 0x1000));
+        }
+        if(!mapped)
+            continue;
+
+        u32 cur = MemScan_Load((const void *)(finderWindow + (address & 0xFFF)), finder.type);
+        if(MemScan_Matches(finder.type, finder.compare, cur, finderResults[i].value, finder.value))
+        {
+            finderResults[kept].address = address;
+            finderResults[kept].value = cur;
+            kept++;
+        }
+    }
+
+    if(mapped)
+        svcUnmapProcessMemoryEx(CUR_PROCESS_HANDLE, finderWindow, 0x1000);
+
+    finder.candidates = kept;
+}
+
+static Result CheatFinder_Scan(void)
+{
+    Handle processHandle;
+    Result res = svcOpenProcess(&processHandle, finder.pid);
+    if(R_FAILED(res))
+        return res;
+
+    // note: mappableFree doesn't do anything, so the window is reserved once and kept
+    if(finderWindow == 0)
+        finderWindow = (u32)mappableAlloc(FINDER_CHUNK_SIZE);
+
+    if(finder.passes == 0)
+        CheatFinder_FindRegions(processHandle);
+
+    if(finder.listMode)
+        CheatFinder_ScanList(processHandle);
+    else
+    {
+        res = CheatFinder_ScanBitmap(processHandle);
+        if(R_SUCCEEDED(res) && finder.candidates <= FINDER_MAX_RESULTS)
+            res = CheatFinder_CollectResults();
+    }
+
+    svcCloseHandle(processHandle);
+
+    if(R_SUCCEEDED(res))
+    {
+        finder.passes++;
+        if(finder.compare == MEMSCAN_CMP_UNKNOWN)
+            finder.compare = MEMSCAN_CMP_CHANGED;
+    }
+    return res;
+}
+
+static MemScanCompare CheatFinder_NextCompare(MemScanCompare cmp)
+{
+    // The first pass has nothing to compare against
+    do
+        cmp = (MemScanCompare)((cmp + 1) % MEMSCAN_CMP_COUNT);
+    while(finder.passes == 0 ? MemScan_NeedsPrevious(cmp) : cmp == MEMSCAN_CMP_UNKNOWN);
+    return cmp;
+}
+
+void RosalinaMenu_CheatFinder(void)
+{
+    FS_ProgramInfo programInfo;
+    u32 pid;
+    u32 launchFlags;
+    Result res = PMDBG_GetCurrentAppInfo(&programInfo, &pid, &launchFlags);
+
+    Draw_Lock();
+    Draw_ClearFramebuffer();
+    Draw_FlushFramebuffer();
+    Draw_Unlock();
+
+    if(R_FAILED(res))
+    {
+        do
+        {
+            Draw_Lock();
+            Draw_DrawString(10, 10, COLOR_TITLE, "Buscador de trucos");
+            Draw_DrawString(10, 30, COLOR_WHITE, "Titulo adecuado no encontrado");
+            Draw_FlushFramebuffer();
+            Draw_Unlock();
+        }
+        while(!(waitInput() & KEY_B) && !menuShouldExit);
+        return;
+    }
+
+    if(finder.titleId != programInfo.programId || finder.pid != pid)
+        CheatFinder_Reset(pid, programInfo.programId);
+
+    u32 digit = 0;
+    res = 0;
+    do
+    {
+        u32 digits = 2 * MemScan_TypeSize(finder.type);
+        u32 posY = 30;
+
+        Draw_Lock();
+        Draw_DrawString(10, 10, COLOR_TITLE, "Buscador de trucos");
+        Draw_DrawFormattedString(10, posY, COLOR_WHITE, "Tipo: %-5s   Comparacion: %s", finderTypeNames[finder.type], finderCompareNames[finder.compare]);
+        posY += SPACING_Y;
+        Draw_DrawFormattedString(10, posY, COLOR_WHITE, "Valor: %0*lX", (int)digits, finder.value);
+        Draw_DrawFormattedString(10 + SPACING_X * (7 + digits - 1 - digit), posY, COLOR_GREEN, "%lX", (finder.value >> (4 * digit)) & 0xF);
+        posY += 2 * SPACING_Y;
+
+        if(R_FAILED(res))
+            Draw_DrawFormattedString(10, posY, COLOR_RED, "ERROR: %08lx", res);
+        else if(finder.passes == 0)
+            Draw_DrawString(10, posY, COLOR_WHITE, "Ninguna busqueda iniciada");
+        else
+            Draw_DrawFormattedString(10, posY, COLOR_WHITE, "Candidatos: %lu (busqueda %lu)", finder.candidates, finder.passes);
+        posY += SPACING_Y;
+
+        for(u32 i = 0; finder.listMode && i < CHEAT_FINDER_RESULTS_PER_PAGE && i < finder.candidates; i++)
+        {
+            posY += SPACING_Y;
+            Draw_DrawFormattedString(30, posY, COLOR_WHITE, "%08lX    %0*lX", finderResults[i].address, (int)digits, finderResults[i].value);
+        }
+
+        if(finder.regionsTruncated)
+            Draw_DrawFormattedString(10, SCREEN_BOT_HEIGHT - 10 - 3 * SPACING_Y, COLOR_RED, "Aviso: solo se buscan %d bloques de memoria", FINDER_MAX_REGIONS);
+
+        posY = SCREEN_BOT_HEIGHT - 10 - 2 * SPACING_Y;
+        Draw_DrawString(10, posY, COLOR_TITLE, "A: buscar   X: reiniciar   SELECT: comparacion");
+        Draw_DrawString(10, posY + SPACING_Y, COLOR_TITLE, "L/R: tipo   Cruceta: editar valor");
+        Draw_FlushFramebuffer();
+        Draw_Unlock();
+
+        if(menuShouldExit)
+            break;
+
+        u32 pressed = waitInputWithTimeout(1000);
+        if(pressed & KEY_B)
+            break;
+        else if(pressed & KEY_A)
+        {
+            Draw_Lock();
+            Draw_ClearFramebuffer();
+            Draw_Unlock();
+            res = CheatFinder_Scan();
+        }
+        else if(pressed & KEY_X)
+        {
+            CheatFinder_Reset(finder.pid, finder.titleId);
+            res = 0;
+        }
+        else if(pressed & KEY_SELECT)
+            finder.compare = CheatFinder_NextCompare(finder.compare);
+        else if((pressed & (KEY_L | KEY_R)) && finder.passes == 0)
+        {
+            finder.type = (MemScanType)((finder.type + ((pressed & KEY_L) ? MEMSCAN_TYPE_COUNT - 1 : 1)) % MEMSCAN_TYPE_COUNT);
+            finder.value &= MemScan_TypeSize(finder.type) == 4 ? 0xFFFFFFFF : (1u << (8 * MemScan_TypeSize(finder.type))) - 1;
+            digit = 0;
+        }
+        else if(pressed & KEY_LEFT)
+            digit = (digit + 1) % digits;
+        else if(pressed & KEY_RIGHT)
+            digit = (digit + digits - 1) % digits;
+        else if(pressed & (KEY_UP | KEY_DOWN))
+        {
+            u32 nibble = (finder.value >> (4 * digit)) & 0xF;
+            nibble = (nibble + ((pressed & KEY_UP) ? 1 : 0xF)) & 0xF;
+            finder.value = (finder.value & ~(0xFu << (4 * digit))) | (nibble << (4 * digit));
+        }
+
+        if(pressed != 0)
+        {
+            Draw_Lock();
+            Draw_ClearFramebuffer();
+            Draw_Unlock();
+        }
+    }
+    while(!menuShouldExit);
+}
@@ -34,10 +34,88 @@
 #include "fmt.h"
 #include "ifile.h"
 #include "pmdbgext.h"
+#include "csvc.h"
 
 #define MAKE_QWORD(hi,low) \
     ((u64) ((((u64)(hi)) << 32) | (low)))
 
+typedef enum CheatOpcode
+{
+    CHEAT_OP_INVALID = 0,
+    CHEAT_OP_NOP,
+    CHEAT_OP_WRITE32,
+    CHEAT_OP_WRITE16,
+    CHEAT_OP_WRITE8,
+    CHEAT_OP_IF32,
+    CHEAT_OP_IF16,
+    CHEAT_OP_LOAD_OFFSET,
+    CHEAT_OP_LOOP,
+    CHEAT_OP_END_IF,
+    CHEAT_OP_BREAK,
+    CHEAT_OP_END_LOOP,
+    CHEAT_OP_END_ALL,
+    CHEAT_OP_RETURN,
+    CHEAT_OP_SET_OFFSET,
+    // D4 to DB, in code type order
+    CHEAT_OP_ADD_DATA,
+    CHEAT_OP_SET_DATA,
+    CHEAT_OP_STORE32,
+    CHEAT_OP_STORE16,
+    CHEAT_OP_STORE8,
+    CHEAT_OP_LOAD32,
+    CHEAT_OP_LOAD16,
+    CHEAT_OP_LOAD8,
+    CHEAT_OP_ADD_OFFSET,
+    CHEAT_OP_IF_KEYS,
+    CHEAT_OP_IF_TOUCH,
+    CHEAT_OP_MOVE_OFFSET,
+    CHEAT_OP_MOVE_DATA,
+    CHEAT_OP_MOVE_STORAGE,
+    CHEAT_OP_DATA_MODE,
+    CHEAT_OP_CONDITIONAL_MODE,
+    CHEAT_OP_WRITE_BYTES,
+    CHEAT_OP_FLOAT_MODE,
+    CHEAT_OP_ARITH_MEMORY,
+    CHEAT_OP_ARITH_DATA,
+    CHEAT_OP_COPY_BYTES,
+    CHEAT_OP_SEARCH,
+    CHEAT_OP_RANDOM,
+
+    CHEAT_OP_COUNT
+} CheatOpcode;
+
+enum
+{
+    CHEAT_COMPARE_LT = 0,
+    CHEAT_COMPARE_GT,
+    CHEAT_COMPARE_EQ,
+    CHEAT_COMPARE_NE,
+};
+
+enum
+{
+    CHEAT_ARITH_ADD = 0,
+    CHEAT_ARITH_MUL,
+    CHEAT_ARITH_DIV,
+    CHEAT_ARITH_AND,
+    CHEAT_ARITH_OR,
+    CHEAT_ARITH_XOR,
+    CHEAT_ARITH_NOT,
+    CHEAT_ARITH_SHL,
+    CHEAT_ARITH_SHR,
+};
+
+// Code lines are decoded once when the cheats are loaded; ops[i] always matches codes[i], so that
+// loop and jump targets keep using line numbers
+typedef struct CheatOp
+{
+    u8 opcode;
+    u8 arg;         // Comparison, register or arithmetic selector
+    u16 target;     // Line to resume from, for breaks and ops with payload lines
+    u32 address;
+    u32 value;
+} CheatOp;
+
 typedef struct CheatDescription
 {
     struct {
@@ -50,21 +128,94 @@ typedef struct CheatDescription
     u32 codesCount;
     u32 storage1;
     u32 storage2;
-    u64 codes[0];
+    CheatOp* ops;
+    u16 periodFrames;   // CHEAT_PERIOD_ONCE: only applied when enabled
+    u8 priority;
+    u32 nextFrame;
+    u32 codesIndex;     // Position of the code words in the cheat database, see Cheat_LoadCodes
+    u64* codes;         // NULL until the cheat is enabled
 } CheatDescription;
 
+typedef bool (*CheatOpHandler)(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution);
+
 typedef struct BufferedFile
 {
     IFile file;
     u64 curPos;
     u64 maxPos;
-    char buffer[512];
+    char buffer[0x1000];
 } BufferedFile;
 
-CheatDescription* cheats[1024] = { 0 };
-u8 cheatBuffer[32768] = { 0 };
+// The cheat list and the code words of the enabled cheats are kept in heap pages that are committed as
+// they're needed, at fixed addresses after the GDB contexts. They're given back when cheats are reloaded.
+#define CHEAT_MEMORY_BASE       0x0F000000
+#define CHEAT_LIST_MAX_SIZE     0x00400000
+#define CHEAT_CODES_MAX_SIZE    0x00400000
+#define CHEAT_MAX_CHEATS        (CHEAT_LIST_MAX_SIZE / sizeof(CheatDescription))
+#define CHEAT_MAX_LOADED_CODES  (CHEAT_CODES_MAX_SIZE / sizeof(u64))
+#define CHEAT_STAGING_SIZE      0x1000  // Used to stage database reads and writes while no cheat is enabled
+
+// cheats.txt is compiled to a cheats.bin next to it the first time it's opened, and rebuilt when
+// the text file changes (different size or modification time). Layout: header, code words of every cheat, then the index.
+#define CHEAT_DB_MAGIC          0x4244434C // "LCDB"
+#define CHEAT_DB_VERSION        3
+#define CHEAT_DB_FLAG_KEYCODE   BIT(0)
+
+typedef struct CheatDbHeader
+{
+    u32 magic;
+    u16 version;
+    u16 cheatCount;
+    u32 sourceSize;     // Size of the cheats.txt this was built from
+    u32 codesOffset;
+    u32 codesCount;
+    u32 indexOffset;
+    u64 sourceTime;     // Its modification time
+} CheatDbHeader;
+
+typedef struct CheatDbEntry
+{
+    char name[39];
+    u8 flags;
+    u32 codesIndex;     // First code word of the cheat, counted from codesOffset
+    u32 codesCount;
+    u16 periodFrames;
+    u8 priority;
+    u8 reserved;
+} CheatDbEntry;
+
+_Static_assert(CHEAT_MAX_CHEATS <= 0xFFFF, "The cheat count of the database header is a u16");
+
+typedef struct CheatArena
+{
+    u32 base;
+    u32 size;       // Committed so far
+    u32 maxSize;
+} CheatArena;
+
+static CheatArena cheatListArena = { CHEAT_MEMORY_BASE, 0, CHEAT_LIST_MAX_SIZE };
+static CheatArena cheatCodesArena = { CHEAT_MEMORY_BASE + CHEAT_LIST_MAX_SIZE, 0, CHEAT_CODES_MAX_SIZE };
+static CheatArena cheatOpsArena = {
+    CHEAT_MEMORY_BASE + CHEAT_LIST_MAX_SIZE + CHEAT_CODES_MAX_SIZE, 0, CHEAT_MAX_LOADED_CODES * sizeof(CheatOp)
+};
+
+static CheatDescription* const cheats = (CheatDescription*) CHEAT_MEMORY_BASE;
+static bool cheatsTruncated = false;    // Some cheats of the text file couldn't be loaded
 u8 cheatPage[0x1000] = { 0 };
 
+// Only the code words of enabled cheats are kept in memory, packed in the order they were enabled
+static u64* const cheatCodes = (u64*) (CHEAT_MEMORY_BASE + CHEAT_LIST_MAX_SIZE);
+static CheatOp* const cheatOps = (CheatOp*) (CHEAT_MEMORY_BASE + CHEAT_LIST_MAX_SIZE + CHEAT_CODES_MAX_SIZE);
+static u32 cheatLoadedCodes = 0;
+
+// Either the cheats.bin, or the cheats.txt itself when no database could be written; in the
+// latter case codesIndex is the offset of the first code line in the text file
+static char cheatDbPath[64];
+static bool cheatDbIsBinary = false;
+static u32 cheatDbCodesOffset = 0;
+static BufferedFile cheatFile;
+static char cheatLine[1024];
+
 typedef struct CheatState
 {
     u32 index;
@@ -93,8 +244,54 @@ typedef struct CheatState
 
 } CheatState;
 
+typedef struct CheatMemoryRegion
+{
+    u32 base;
+    u32 size;
+} CheatMemoryRegion;
+
+#define CHEAT_MAX_CACHED_REGIONS 32
+
+// Non-free memory blocks of the cheat target, sorted by base address. Blocks are added when an
+// address misses the cache, and everything is dropped when an access to the target fails or the
+// target process changes.
+static CheatMemoryRegion cheatRegions[CHEAT_MAX_CACHED_REGIONS];
+static u32 cheatRegionCount = 0;
+static u32 cheatRegionsPid = 0xFFFFFFFF;
+
+#define CHEAT_MAPPED_PAGE_COUNT 64
+
+typedef struct CheatMappedPage
+{
+    u32 address;
+    bool mapped;
+} CheatMappedPage;
+
+// Target pages mapped into a small window of our address space for the length of a batch, so that
+// repeated accesses to them are plain loads and stores. Pages are direct-mapped to window slots.
+static Handle cheatProcessHandle = 0;
+static u32 cheatMapWindow = 0;
+static CheatMappedPage cheatMappedPages[CHEAT_MAPPED_PAGE_COUNT] = { 0 };
+static bool cheatMappedWrites = false;
+
+// Cheats are run by their own thread, ticking at the LCD refresh rate. GSP owns the VBlank
+// interrupts, so a periodic timer is used instead.
+#define CHEAT_FRAME_PERIOD_NS       16713680LL  // 59.83 Hz
+#define CHEAT_DEFAULT_PERIOD_MS     50
+#define CHEAT_PERIOD_ONCE           0
+#define CHEAT_MAX_PRIORITY          7
+// Cheats still due once a batch used up its budget are deferred to the next frame
+#define CHEAT_BATCH_BUDGET_TICKS    (2 * SYSCLOCK_ARM11 / 1000)
+
+static MyThread cheatThread;
+static u8 ALIGN(8) cheatThreadStack[0x1000];
+static LightLock cheatLock;
+static u32 cheatFrame = 0;
+static u64 cheatLastBatchTicks = 0;
+static u64 cheatMaxBatchTicks = 0;
+
 CheatState cheat_state = { 0 };
-u8 cheatCount = 0;
+s32 cheatCount = 0;
 u64 cheatTitleInfo = -1ULL;
 u64 cheatRngState = 0;
 
@@ -121,13 +318,112 @@ static u32 Cheat_GetRandomNumber(void)
     return (u32)(cheatRngState >> 32);
 }
 
+static s32 Cheat_FindCachedRegion(u32 address)
+{
+    // Last cached region starting at or before address
+    s32 low = 0, high = (s32)cheatRegionCount - 1, found = -1;
+    while (low <= high)
+    {
+        s32 mid = (low + high) / 2;
+        if (cheatRegions[mid].base <= address)
+        {
+            found = mid;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    return found;
+}
+
+static void Cheat_CacheRegion(u32 base, u32 size)
+{
+    // Anything overlapping the new block is stale
+    u32 count = 0;
+    for (u32 i = 0; i < cheatRegionCount; i++)
+    {
+        if (cheatRegions[i].base + cheatRegions[i].size <= base || cheatRegions[i].base >= base + size)
+        {
+            cheatRegions[count++] = cheatRegions[i];
+        }
+    }
+    cheatRegionCount = count == CHEAT_MAX_CACHED_REGIONS ? 0 : count;
+
+    u32 pos = cheatRegionCount;
+    while (pos > 0 && cheatRegions[pos - 1].base > base)
+    {
+        cheatRegions[pos] = cheatRegions[pos - 1];
+        pos--;
+    }
+    cheatRegions[pos].base = base;
+    cheatRegions[pos].size = size;
+    cheatRegionCount++;
+}
+
+static inline bool Cheat_CheckAccess(Result res)
+{
+    // The memory map changed under us, query it again
+    if (R_FAILED(res))
+    {
+        cheatRegionCount = 0;
+    }
+    return R_SUCCEEDED(res);
+}
+
+static inline bool Cheat_IsMappableAddress(u32 address)
+{
+    // Code, heap and linear heap (old and new mappings). Anything else may be IO, leave it to the kernel
+    return (address >= 0x00100000 && address < 0x04000000) ||
+           (address >= 0x08000000 && address < 0x10000000) ||
+           (address >= 0x14000000 && address < 0x1C000000) ||
+           (address >= 0x30000000 && address < 0x40000000);
+}
+
+static void* Cheat_GetMappedAddress(u32 address, u32 size)
+{
+    u32 page = address & ~0xFFF;
+    if (cheatMapWindow == 0 || cheatProcessHandle == 0 || !Cheat_IsMappableAddress(address) || address + size > page + 0x1000)
+    {
+        return NULL;
+    }
+
+    u32 slot = (page >> 12) % CHEAT_MAPPED_PAGE_COUNT;
+    u32 dst = cheatMapWindow + slot * 0x1000;
+    CheatMappedPage* mappedPage = &cheatMappedPages[slot];
+    if (mappedPage->address != page)
+    {
+        if (mappedPage->mapped)
+        {
+            if (cheatMappedWrites)
+            {
+                svcFlushEntireDataCache();
+            }
+            svcUnmapProcessMemoryEx(CUR_PROCESS_HANDLE, dst, 0x1000);
+        }
+        // Remember failures too, so that we don't retry the mapping on each access
+        mappedPage->address = page;
+        mappedPage->mapped = R_SUCCEEDED(svcMapProcessMemoryEx(CUR_PROCESS_HANDLE, dst, cheatProcessHandle, page, 0x1000));
+    }
+
+    return mappedPage->mapped ? (void*)(dst + (address - page)) : NULL;
+}
+
 static bool Cheat_IsValidAddress(const Handle processHandle, u32 address, u32 size)
 {
+    s32 idx = Cheat_FindCachedRegion(address);
+    if (idx >= 0 && address - cheatRegions[idx].base <= cheatRegions[idx].size - size)
+    {
+        return true;
+    }
+
     MemInfo info;
     PageInfo out;
 
     Result res = svcQueryDebugProcessMemory(&info, &out, processHandle, address);
     if (R_SUCCEEDED(res) && info.state != MEMSTATE_FREE && info.base_addr > 0 && info.base_addr <= address && address <= info.base_addr + info.size - size) {
+        Cheat_CacheRegion(info.base_addr, info.size);
         return true;
     }
     return false;
@@ -147,8 +443,15 @@ static bool Cheat_Write8(const Handle processHandle, u32 offset, u8 value)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 1))
     {
+        u8* mapped = Cheat_GetMappedAddress(addr, 1);
+        if (mapped != NULL)
+        {
+            *mapped = value;
+            cheatMappedWrites = true;
+            return true;
+        }
         *((u8*) (&ReadWriteBuffer8)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer8, addr, 1));
+        return Cheat_CheckAccess(svcWriteProcessMemory(processHandle, &ReadWriteBuffer8, addr, 1));
     }
     return false;
 }
@@ -163,8 +466,15 @@ static bool Cheat_Write16(const Handle processHandle, u32 offset, u16 value)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 2))
     {
+        u16* mapped = Cheat_GetMappedAddress(addr, 2);
+        if (mapped != NULL)
+        {
+            *mapped = value;
+            cheatMappedWrites = true;
+            return true;
+        }
         *((u16*) (&ReadWriteBuffer16)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer16, addr, 2));
+        return Cheat_CheckAccess(svcWriteProcessMemory(processHandle, &ReadWriteBuffer16, addr, 2));
     }
     return false;
 }
@@ -179,8 +489,15 @@ static bool Cheat_Write32(const Handle processHandle, u32 offset, u32 value)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 4))
     {
+        u32* mapped = Cheat_GetMappedAddress(addr, 4);
+        if (mapped != NULL)
+        {
+            *mapped = value;
+            cheatMappedWrites = true;
+            return true;
+        }
         *((u32*) (&ReadWriteBuffer32)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer32, addr, 4));
+        return Cheat_CheckAccess(svcWriteProcessMemory(processHandle, &ReadWriteBuffer32, addr, 4));
     }
     return false;
 }
@@ -195,9 +512,15 @@ static bool Cheat_Read8(const Handle processHandle, u32 offset, u8* retValue)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 1))
     {
+        u8* mapped = Cheat_GetMappedAddress(addr, 1);
+        if (mapped != NULL)
+        {
+            *retValue = *mapped;
+            return true;
+        }
         Result res = svcReadProcessMemory(&ReadWriteBuffer8, processHandle, addr, 1);
         *retValue = *((u8*) (&ReadWriteBuffer8));
-        return R_SUCCEEDED(res);
+        return Cheat_CheckAccess(res);
     }
     return false;
 }
@@ -212,9 +535,15 @@ static bool Cheat_Read16(const Handle processHandle, u32 offset, u16* retValue)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 2))
     {
+        u16* mapped = Cheat_GetMappedAddress(addr, 2);
+        if (mapped != NULL)
+        {
+            *retValue = *mapped;
+            return true;
+        }
         Result res = svcReadProcessMemory(&ReadWriteBuffer16, processHandle, addr, 2);
         *retValue = *((u16*) (&ReadWriteBuffer16));
-        return R_SUCCEEDED(res);
+        return Cheat_CheckAccess(res);
     }
     return false;
 }
@@ -229,1386 +558,1203 @@ static bool Cheat_Read32(const Handle processHandle, u32 offset, u32* retValue)
     }
     if (Cheat_IsValidAddress(processHandle, addr, 4))
     {
+        u32* mapped = Cheat_GetMappedAddress(addr, 4);
+        if (mapped != NULL)
+        {
+            *retValue = *mapped;
+            return true;
+        }
         Result res = svcReadProcessMemory(&ReadWriteBuffer32, processHandle, addr, 4);
         *retValue = *((u32*) (&ReadWriteBuffer32));
-        return R_SUCCEEDED(res);
+        return Cheat_CheckAccess(res);
     }
     return false;
 }
 
-static u8 typeEMapping[] = { 4 << 3, 5 << 3, 6 << 3, 7 << 3, 0 << 3, 1 << 3, 2 << 3, 3 << 3 };
+static inline u32* selectedData(u8 which)
+{
+    return which == 0 ? activeData() : (which == 1 ? &cheat_state.data1 : &cheat_state.data2);
+}
 
-static u8 Cheat_GetNextTypeE(const CheatDescription* cheat)
+static inline void Cheat_PushCondition(bool newSkip, bool skipExecution)
 {
+    cheat_state.ifStack <<= 1;
+    cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
+    cheat_state.ifCount++;
+}
 
-    if (cheat_state.typeEIdx == 7)
+static bool Cheat_Compare(u8 comparison, u32 lhs, u32 rhs)
+{
+    switch (comparison)
     {
-        cheat_state.typeEIdx = 0;
-        cheat_state.typeELine++;
+        case CHEAT_COMPARE_LT:
+            return lhs < rhs;
+        case CHEAT_COMPARE_GT:
+            return lhs > rhs;
+        case CHEAT_COMPARE_EQ:
+            return lhs == rhs;
+        default:
+            return lhs != rhs;
     }
-    else
+}
+
+static bool Cheat_OpInvalid(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)op;
+    (void)skipExecution;
+    return false;
+}
+
+static bool Cheat_OpNop(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)op;
+    (void)skipExecution;
+    return true;
+}
+
+static bool Cheat_OpWrite32(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    return skipExecution || Cheat_Write32(processHandle, op->address, op->value);
+}
+
+static bool Cheat_OpWrite16(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    return skipExecution || Cheat_Write16(processHandle, op->address, (u16) op->value);
+}
+
+static bool Cheat_OpWrite8(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    return skipExecution || Cheat_Write8(processHandle, op->address, (u8) op->value);
+}
+
+static bool Cheat_OpIf32(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    u32 lhs, rhs;
+    switch (cheat_state.conditionalMode)
     {
-        cheat_state.typeEIdx++;
+        case 0x0:
+            if (!Cheat_Read32(processHandle, op->address, &lhs)) return false;
+            rhs = op->value;
+            break;
+        case 0x1:
+            if (!Cheat_Read32(processHandle, op->address, &lhs)) return false;
+            rhs = *activeData();
+            break;
+        case 0x2:
+            lhs = *activeData();
+            rhs = op->value;
+            break;
+        case 0x3:
+            lhs = *activeStorage(cheat);
+            rhs = op->value;
+            break;
+        case 0x4:
+            lhs = *activeData();
+            rhs = *activeStorage(cheat);
+            break;
+        default:
+            return false;
     }
-    return (u8) ((cheat->codes[cheat_state.typeELine] >> (typeEMapping[cheat_state.typeEIdx])) & 0xFF);
+
+    Cheat_PushCondition(!Cheat_Compare(op->arg, lhs, rhs), skipExecution);
+    return true;
 }
 
-static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const cheat)
+static bool Cheat_OpIf16(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
 {
-    cheat_state.index = 0;
-    cheat_state.offset1 = 0;
-    cheat_state.offset2 = 0;
-    cheat_state.data1 = 0;
-    cheat_state.data2 = 0;
-    cheat_state.activeOffset = 0;
-    cheat_state.activeData = 0;
-    cheat_state.conditionalMode = 0;
-    cheat_state.data1Mode = 0;
-    cheat_state.data2Mode = 0;
-    cheat_state.floatMode = 0;
-    cheat_state.loopCount = 0;
-    cheat_state.loopLine = -1;
-    cheat_state.ifStack = 0;
-    cheat_state.storedStack = 0;
-    cheat_state.ifCount = 0;
-    cheat_state.storedIfCount = 0;
+    // The mask only clears the low 16 bits: registers keep their upper half when compared
+    u32 keep = ~(op->value >> 16);
+    u32 imm = op->value & 0xFFFF;
+    u16 value = 0;
+    u32 lhs, rhs;
+    switch (cheat_state.conditionalMode)
+    {
+        case 0x0:
+            if (!Cheat_Read16(processHandle, op->address, &value)) return false;
+            lhs = value & keep;
+            rhs = imm;
+            break;
+        case 0x1:
+            if (!Cheat_Read16(processHandle, op->address, &value)) return false;
+            lhs = value & keep;
+            rhs = *activeData() & keep;
+            break;
+        case 0x2:
+            lhs = *activeData() & keep;
+            rhs = imm;
+            break;
+        case 0x3:
+            lhs = *activeStorage(cheat) & keep;
+            rhs = imm;
+            break;
+        case 0x4:
+            lhs = *activeData() & keep;
+            rhs = *activeStorage(cheat) & keep;
+            break;
+        default:
+            return false;
+    }
 
-    while (cheat_state.index < cheat->codesCount)
+    Cheat_PushCondition(!Cheat_Compare(op->arg, lhs, rhs), skipExecution);
+    return true;
+}
+
+static bool Cheat_OpLoadOffset(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
     {
-        bool skipExecution = (cheat_state.ifStack & 0x00000001) != 0;
-        u32 arg0 = (u32) ((cheat->codes[cheat_state.index] >> 32) & 0x00000000FFFFFFFFULL);
-        u32 arg1 = (u32) ((cheat->codes[cheat_state.index]) & 0x00000000FFFFFFFFULL);
-        if (arg0 == 0 && arg1 == 0)
+        u32 value;
+        if (!Cheat_Read32(processHandle, op->address, &value)) return false;
+        *activeOffset() = value;
+    }
+    return true;
+}
+
+static bool Cheat_OpLoop(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)skipExecution;
+    cheat_state.loopLine = cheat_state.index;
+    cheat_state.loopCount = op->arg == 0 ? op->value : (op->arg == 1 ? cheat_state.data1 : cheat_state.data2);
+    cheat_state.storedStack = cheat_state.ifStack;
+    cheat_state.storedIfCount = cheat_state.ifCount;
+    return true;
+}
+
+static bool Cheat_OpEndIf(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)op;
+    (void)skipExecution;
+    if (cheat_state.loopLine != -1)
+    {
+        if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
         {
-            return 0;
+            cheat_state.ifStack >>= 1;
+            cheat_state.ifCount--;
         }
-        u32 code = ((arg0 >> 28) & 0x0F);
-        u32 subcode = ((arg0 >> 24) & 0x0F);
-        u32 codeArg = arg0 & 0x0F;
-
-        switch (code)
+        else if (cheat_state.loopCount > 0)
         {
-            case 0x0:
-                // 0 Type
-                // Format: 0XXXXXXX YYYYYYYY
-                // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write32(processHandle, (arg0 & 0x0FFFFFFF), arg1)) return 0;
-                }
-                break;
-            case 0x1:
-                // 1 Type
-                // Format: 1XXXXXXX 0000YYYY
-                // Description: 16bit write of YYYY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write16(processHandle, (arg0 & 0x0FFFFFFF), (u16) (arg1 & 0xFFFF))) return 0;
-                }
-                break;
-            case 0x2:
-                // 2 Type
-                // Format: 2XXXXXXX 000000YY
-                // Description: 8bit write of YY to 0XXXXXXX.
-                if (!skipExecution)
-                {
-                    if (!Cheat_Write8(processHandle, (arg0 & 0x0FFFFFFF), (u8) (arg1 & 0xFF))) return 0;
-                }
-                break;
-            case 0x3:
-                // 3 Type
-                // Format: 3XXXXXXXX YYYYYYYY
-                // Description: 32bit if less than.
-                // Simple: If the value at address 0XXXXXXX is less than the value YYYYYYYY.
-                // Example: 323D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value < arg1);
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value < *activeData());
-                        break;
-                    case 0x2:
-                        newSkip = !(*activeData() < arg1);
-                        break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) < arg1);
-                        break;
-                    case 0x4:
-                        newSkip = !(*activeData() < *activeStorage(cheat));
-                        break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x4:
-                // 4 Type
-                // Format: 4XXXXXXXX YYYYYYYY
-                // Description: 32bit if greater than.
-                // Simple: If the value at address 0XXXXXXX is greater than the value YYYYYYYY.
-                // Example: 423D6B28 10000000
-            {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value > arg1);
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value > *activeData());
-                        break;
-                    case 0x2:
-                        newSkip = !(*activeData() > arg1);
-                        break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) > arg1);
-                        break;
-                    case 0x4:
-                        newSkip = !(*activeData() > *activeStorage(cheat));
-                        break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x5:
-                // 5 Type
-                // Format: 5XXXXXXXX YYYYYYYY
-                // Description: 32bit if equal to.
-                // Simple: If the value at address 0XXXXXXX is equal to the value YYYYYYYY.
-                // Example: 523D6B28 10000000
+            cheat_state.loopCount--;
+            if (cheat_state.loopCount == 0)
             {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value == arg1);
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value == *activeData());
-                        break;
-                    case 0x2:
-                        newSkip = !(*activeData() == arg1);
-                        break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) == arg1);
-                        break;
-                    case 0x4:
-                        newSkip = !(*activeData() == *activeStorage(cheat));
-                        break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
+                cheat_state.loopLine = -1;
             }
-                break;
-            case 0x6:
-                // 6 Type
-                // Format: 3XXXXXXXX YYYYYYYY
-                // Description: 32bit if not equal to.
-                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYYYYYY.
-                // Example: 623D6B28 10000000
+            else
             {
-                bool newSkip;
-                u32 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value != arg1);
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !(value != *activeData());
-                        break;
-                    case 0x2:
-                        newSkip = !(*activeData() != arg1);
-                        break;
-                    case 0x3:
-                        newSkip = !(*activeStorage(cheat) != arg1);
-                        break;
-                    case 0x4:
-                        newSkip = !(*activeData() != *activeStorage(cheat));
-                        break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
+                cheat_state.index = cheat_state.loopLine;
             }
-                break;
-            case 0x7:
-                // 7 Type
-                // Format: 7XXXXXXXX 0000YYYY
-                // Description: 16bit if less than.
-                // Simple: If the value at address 0XXXXXXX is less than the value YYYY.
-                // Example: 723D6B28 00005400
+        }
+    }
+    else if (cheat_state.ifCount > 0)
+    {
+        cheat_state.ifStack >>= 1;
+        cheat_state.ifCount--;
+    }
+    return true;
+}
+
+static bool Cheat_OpBreak(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        cheat_state.loopCount = 0;
+        cheat_state.loopLine = -1;
+        cheat_state.index = op->target;
+    }
+    return true;
+}
+
+static bool Cheat_OpEndLoop(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)op;
+    (void)skipExecution;
+    if (cheat_state.loopCount > 0)
+    {
+        cheat_state.ifStack = cheat_state.storedStack;
+        cheat_state.ifCount = cheat_state.storedIfCount;
+        cheat_state.loopCount--;
+        if (cheat_state.loopCount == 0)
+        {
+            cheat_state.loopLine = -1;
+        }
+        else if (cheat_state.loopLine != -1)
+        {
+            cheat_state.index = cheat_state.loopLine;
+        }
+    }
+    return true;
+}
+
+static bool Cheat_OpEndAll(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)op;
+    (void)skipExecution;
+    if (cheat_state.loopCount > 0)
+    {
+        cheat_state.loopCount--;
+        if (cheat_state.loopCount != 0)
+        {
+            if (cheat_state.loopLine != -1)
             {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) < (arg1 & 0xFFFF));
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) < (*activeData() & (~mask)));
-                        break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) < (arg1 & 0xFFFF));
-                        break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) < (arg1 & 0xFFFF));
-                        break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) < (*activeStorage(cheat) & (~mask)));
-                        break;
-                    default:
-                        return 0;
-                }
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
+                cheat_state.index = cheat_state.loopLine;
             }
-                break;
-            case 0x8:
-                // 8 Type
-                // Format: 8XXXXXXXX 0000YYYY
-                // Description: 16bit if greater than.
-                // Simple: If the value at address 0XXXXXXX is greater than the value YYYY.
-                // Example: 823D6B28 00005400
-            {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) > (arg1 & 0xFFFF));
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) > (*activeData() & (~mask)));
-                        break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) > (arg1 & 0xFFFF));
-                        break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) > (arg1 & 0xFFFF));
-                        break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) > (*activeStorage(cheat) & (~mask)));
-                        break;
-                    default:
-                        return 0;
-                }
+            return true;
+        }
+        cheat_state.loopLine = -1;
+    }
 
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0x9:
-                // 9 Type
-                // Format: 9XXXXXXXX 0000YYYY
-                // Description: 16bit if equal to.
-                // Simple: If the value at address 0XXXXXXX is equal to the value YYYY.
-                // Example: 923D6B28 00005400
-            {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) == (arg1 & 0xFFFF));
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) == (*activeData() & (~mask)));
-                        break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) == (arg1 & 0xFFFF));
-                        break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) == (arg1 & 0xFFFF));
-                        break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) == (*activeStorage(cheat) & (~mask)));
-                        break;
-                    default:
-                        return 0;
-                }
+    *activeData() = 0;
+    *activeOffset() = 0;
+    cheat_state.ifStack = 0;
+    cheat_state.ifCount = 0;
+    return true;
+}
 
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
-                break;
-            case 0xA:
-                // A Type
-                // Format: AXXXXXXXX 0000YYYY
-                // Description: 16bit if not equal to.
-                // Simple: If the value at address 0XXXXXXX is not equal to the value YYYY.
-                // Example: A23D6B28 00005400
-            {
-                bool newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
-                u16 value = 0;
-                switch (cheat_state.conditionalMode)
-                {
-                    case 0x0:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) != (arg1 & 0xFFFF));
-                        break;
-                    case 0x1:
-                        if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                        newSkip = !((value & (~mask)) != (*activeData() & (~mask)));
-                        break;
-                    case 0x2:
-                        newSkip = !((*activeData() & (~mask)) != (arg1 & 0xFFFF));
-                        break;
-                    case 0x3:
-                        newSkip = !((*activeStorage(cheat) & (~mask)) != (arg1 & 0xFFFF));
-                        break;
-                    case 0x4:
-                        newSkip = !((*activeData() & (~mask)) != (*activeStorage(cheat) & (~mask)));
-                        break;
-                    default:
-                        return 0;
-                }
+static bool Cheat_OpReturn(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)op;
+    if (!skipExecution)
+    {
+        cheat_state.index = cheat->codesCount;
+    }
+    return true;
+}
 
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                cheat_state.ifCount++;
-            }
+static bool Cheat_OpSetOffset(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        *(op->arg == 0 ? &cheat_state.offset1 : &cheat_state.offset2) = op->value;
+    }
+    return true;
+}
+
+static bool Cheat_OpAddData(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        if (op->arg == 0)
+        {
+            *activeData() += op->value;
+        }
+        else if (op->arg == 1)
+        {
+            cheat_state.data1 += op->value + cheat_state.data2;
+        }
+        else
+        {
+            cheat_state.data2 += op->value + cheat_state.data1;
+        }
+    }
+    return true;
+}
+
+static bool Cheat_OpSetData(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        *selectedData(op->arg) = op->value;
+    }
+    return true;
+}
+
+static bool Cheat_OpStore32(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        if (!Cheat_Write32(processHandle, op->value, *selectedData(op->arg))) return false;
+        *activeOffset() += 4;
+    }
+    return true;
+}
+
+static bool Cheat_OpStore16(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        if (!Cheat_Write16(processHandle, op->value, (u16) (*selectedData(op->arg) & 0xFFFF))) return false;
+        *activeOffset() += 2;
+    }
+    return true;
+}
+
+static bool Cheat_OpStore8(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        if (!Cheat_Write8(processHandle, op->value, (u8) (*selectedData(op->arg) & 0xFF))) return false;
+        *activeOffset() += 1;
+    }
+    return true;
+}
+
+static bool Cheat_OpLoad32(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        u32 value = 0;
+        if (!Cheat_Read32(processHandle, op->value, &value)) return false;
+        *selectedData(op->arg) = value;
+    }
+    return true;
+}
+
+static bool Cheat_OpLoad16(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        u16 value = 0;
+        if (!Cheat_Read16(processHandle, op->value, &value)) return false;
+        *selectedData(op->arg) = value;
+    }
+    return true;
+}
+
+static bool Cheat_OpLoad8(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        u8 value = 0;
+        if (!Cheat_Read8(processHandle, op->value, &value)) return false;
+        *selectedData(op->arg) = value;
+    }
+    return true;
+}
+
+static bool Cheat_OpAddOffset(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        *activeOffset() += op->value;
+    }
+    return true;
+}
+
+static bool Cheat_OpIfKeys(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    Cheat_PushCondition(!(op->value == 0 || (HID_PAD & op->value) == op->value), skipExecution);
+    return true;
+}
+
+static bool Cheat_OpIfTouch(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    u32 highBound = op->value >> 16;
+    u32 lowBound = op->value & 0xFFFF;
+    touchPosition touch;
+    hidTouchRead(&touch);
+    u32 pos = op->arg == 0 ? touch.px : touch.py;
+
+    Cheat_PushCondition(!(lowBound <= pos && highBound >= pos), skipExecution);
+    return true;
+}
+
+static bool Cheat_OpMoveOffset(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)skipExecution;
+    if (op->value & 0x00010000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat_state.offset2 = cheat_state.offset1;
+        }
+        else
+        {
+            cheat_state.offset1 = cheat_state.offset2;
+        }
+    }
+    else if (op->value & 0x00020000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat_state.data2 = cheat_state.offset2;
+        }
+        else
+        {
+            cheat_state.data1 = cheat_state.offset1;
+        }
+    }
+    else
+    {
+        cheat_state.activeOffset = op->value & 0x1;
+    }
+    return true;
+}
+
+static bool Cheat_OpMoveData(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)skipExecution;
+    if (op->value & 0x00010000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat_state.data2 = cheat_state.data1;
+        }
+        else
+        {
+            cheat_state.data1 = cheat_state.data2;
+        }
+    }
+    else if (op->value & 0x00020000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat_state.offset2 = cheat_state.data2;
+        }
+        else
+        {
+            cheat_state.offset1 = cheat_state.data1;
+        }
+    }
+    else
+    {
+        cheat_state.activeData = op->value & 0x1;
+    }
+    return true;
+}
+
+static bool Cheat_OpMoveStorage(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)skipExecution;
+    if (op->value & 0x00010000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat_state.data2 = cheat->storage2;
+        }
+        else
+        {
+            cheat_state.data1 = cheat->storage1;
+        }
+    }
+    else if (op->value & 0x00020000)
+    {
+        if (op->value & 0x1)
+        {
+            cheat->storage2 = cheat_state.data2;
+        }
+        else
+        {
+            cheat->storage1 = cheat_state.data1;
+        }
+    }
+    else
+    {
+        cheat->activeStorage = op->value & 0x1;
+    }
+    return true;
+}
+
+static bool Cheat_OpDataMode(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)skipExecution;
+    u32* data = activeData();
+    bool floatMode = op->value & 0x1;
+
+    if (op->value & 0x10)
+    {
+        // Convert the register along with the mode switch
+        if (floatMode)
+        {
+            float val = *data;
+            memcpy(data, &val, sizeof(float));
+        }
+        else
+        {
+            float val;
+            memcpy(&val, data, sizeof(float));
+            *data = val;
+        }
+    }
+
+    if (cheat_state.activeData)
+    {
+        cheat_state.data2Mode = floatMode;
+    }
+    else
+    {
+        cheat_state.data1Mode = floatMode;
+    }
+    return true;
+}
+
+static bool Cheat_OpConditionalMode(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    (void)skipExecution;
+    cheat_state.conditionalMode = op->arg;
+    return true;
+}
+
+static bool Cheat_OpWriteBytes(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    if (!skipExecution)
+    {
+        // Payload bytes are stored high word first, lowest byte first: byte i of the little-endian
+        // payload words is at i ^ 4
+        const u8* payload = (const u8*) (cheat->codes + cheat_state.index + 1);
+        for (u32 i = 0; i < op->value; i++)
+        {
+            if (!Cheat_Write8(processHandle, op->address + i, payload[i ^ 4])) return false;
+        }
+    }
+    cheat_state.index = op->target;
+    return true;
+}
+
+static bool Cheat_OpFloatMode(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        cheat_state.floatMode = op->value & 0x1;
+    }
+    return true;
+}
+
+static bool Cheat_OpArithMemory(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (skipExecution)
+    {
+        return true;
+    }
+
+    u32 tmp;
+    if (!Cheat_Read32(processHandle, op->address, &tmp)) return false;
+
+    if (cheat_state.floatMode)
+    {
+        float flarg1, value;
+        memcpy(&flarg1, &op->value, sizeof(float));
+        memcpy(&value, &tmp, sizeof(float));
+        switch (op->arg)
+        {
+            case CHEAT_ARITH_ADD:
+                value += flarg1;
+                break;
+            case CHEAT_ARITH_MUL:
+                value *= flarg1;
+                break;
+            default:
+                value /= flarg1;
                 break;
+        }
+        memcpy(&tmp, &value, sizeof(u32));
+    }
+    else
+    {
+        switch (op->arg)
+        {
+            case CHEAT_ARITH_ADD:
+                tmp += op->value;
+                break;
+            case CHEAT_ARITH_MUL:
+                tmp *= op->value;
+                break;
+            default:
+                tmp /= op->value;
+                break;
+        }
+    }
+
+    return Cheat_Write32(processHandle, op->address, tmp);
+}
+
+static bool Cheat_OpArithData(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (skipExecution)
+    {
+        return true;
+    }
+
+    if ((op->arg == CHEAT_ARITH_MUL || op->arg == CHEAT_ARITH_DIV) && cheat_state.data1Mode)
+    {
+        float flarg1, value;
+        memcpy(&flarg1, &op->value, sizeof(float));
+        memcpy(&value, activeData(), sizeof(float));
+        if (op->arg == CHEAT_ARITH_MUL)
+        {
+            value *= flarg1;
+        }
+        else
+        {
+            value /= flarg1;
+        }
+        memcpy(activeData(), &value, sizeof(float));
+        return true;
+    }
+
+    u32* data = activeData();
+    switch (op->arg)
+    {
+        case CHEAT_ARITH_MUL:
+            *data *= op->value;
+            break;
+        case CHEAT_ARITH_DIV:
+            *data /= op->value;
+            break;
+        case CHEAT_ARITH_AND:
+            *data &= op->value;
+            break;
+        case CHEAT_ARITH_OR:
+            *data |= op->value;
+            break;
+        case CHEAT_ARITH_XOR:
+            *data ^= op->value;
+            break;
+        case CHEAT_ARITH_NOT:
+            *data = ~*data;
+            break;
+        case CHEAT_ARITH_SHL:
+            *data <<= op->value;
+            break;
+        default:
+            *data >>= op->value;
+            break;
+    }
+    return true;
+}
+
+static bool Cheat_OpCopyBytes(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)cheat;
+    if (!skipExecution)
+    {
+        u8 origActiveOffset = cheat_state.activeOffset;
+        for (u32 i = 0; i < op->value; i++)
+        {
+            u8 data;
+            cheat_state.activeOffset = 1;
+            if (!Cheat_Read8(processHandle, 0, &data))
+            {
+                return false;
+            }
+            cheat_state.activeOffset = 0;
+            if (!Cheat_Write8(processHandle, 0, data))
+            {
+                return false;
+            }
+        }
+        cheat_state.activeOffset = origActiveOffset;
+    }
+    return true;
+}
 
-            case 0xB:
-                // B Type
-                // Format: BXXXXXXX 00000000
-                // Description: Loads offset register with value at given XXXXXXX
-                if (!skipExecution)
+static bool Cheat_OpSearch(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    bool newSkip = true;
+    if (!skipExecution) // Don't do an expensive operation if we don't have to
+    {
+        u32 searchSize = op->address;
+        const u8* searchData = (const u8*) (cheat->codes + cheat_state.index + 1);
+        cheat_state.index = op->target;
+        for (u32 i = 0; i < op->value - searchSize; i++)
+        {
+            u8 curVal;
+            newSkip = false;
+            for (u32 j = 0; j < searchSize; j++)
+            {
+                if (!Cheat_Read8(processHandle, i + j, &curVal))
                 {
-                    u32 value;
-                    if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                    *activeOffset() = value;
+                    return false;
                 }
-                break;
-            case 0xC:
-                // C Type
-                // Format: C0000000 ZZZZZZZZ
-                // Description: Repeat following lines at specified offset.
-                // Simple: used to write a value to an address, and then continues to write that value Z number of times to all addresses at an offset determined by the (D6, D7, D8, or DC) type following it.
-                // Note: used with the D6, D7, D8, and DC types. C types can not be nested.
-                // Example:
-
-                // C0000000 00000005
-                // 023D6B28 0009896C
-                // DC000000 00000010
-                // D2000000 00000000
-                switch (subcode)
+                if (curVal != searchData[j])
                 {
-                    case 0x00:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = arg1;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
-                    case 0x01:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = cheat_state.data1;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
-                    case 0x02:
-                        cheat_state.loopLine = cheat_state.index;
-                        cheat_state.loopCount = cheat_state.data2;
-                        cheat_state.storedStack = cheat_state.ifStack;
-                        cheat_state.storedIfCount = cheat_state.ifCount;
-                        break;
+                    newSkip = true;
+                    break;
                 }
+            }
+            if (!newSkip)
+            {
                 break;
-            case 0xD:
-                switch (subcode)
-                {
-                    case 0x00:
-                        // D0 Type
-                        // Format: D0000000 00000000
-                        // Description: ends most recent conditional.
-                        // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // 74000100 FF00000C
-                        // 023D6B28 0009896C
-                        // D0000000 00000000
-
-                        // The 7 type line would be terminated.
-                        if (arg1 == 0)
-                        {
-                            if (cheat_state.loopLine != -1)
-                            {
-                                if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
-                                {
-                                    cheat_state.ifStack >>= 1;
-                                    cheat_state.ifCount--;
-                                }
-                                else
-                                {
-
-                                    if (cheat_state.loopCount > 0)
-                                    {
-                                        cheat_state.loopCount--;
-                                        if (cheat_state.loopCount == 0)
-                                        {
-                                            cheat_state.loopLine = -1;
-                                        }
-                                        else if (cheat_state.loopLine != -1)
-                                        {
-                                            cheat_state.index = cheat_state.loopLine;
-                                        }
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                if (cheat_state.ifCount > 0)
-                                {
-                                    cheat_state.ifStack >>= 1;
-                                    cheat_state.ifCount--;
-                                }
-                            }
-                        }
-                        // D0000000 00000001
-                        // Loop break
-                        else if (!skipExecution && arg1 == 1)
-                        {
-                            cheat_state.loopCount = 0;
-                            cheat_state.loopLine = -1;
-                            cheat_state.index++;
-                            while (cheat_state.index < cheat->codesCount)
-                            {
-                                u64 code = cheat->codes[cheat_state.index++];
-                                if (code == 0xD100000000000000ull || code == 0xD200000000000000ull)
-                                {
-                                    break;
-                                }
-                            }
-                        }
-                        break;
-                    case 0x01:
-                        // D1 Type
-                        // Format: D1000000 00000000
-                        // Description: ends repeat block.
-                        // Simple: will end all conditionals within a C type code, along with the C type itself.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D1000000 00000000
-
-                        // The C line, 8 line, 0 line, and D6 line would be terminated.
-                        if (cheat_state.loopCount > 0)
-                        {
-                            cheat_state.ifStack = cheat_state.storedStack;
-                            cheat_state.ifCount = cheat_state.storedIfCount;
-                            cheat_state.loopCount--;
-                            if (cheat_state.loopCount == 0)
-                            {
-                                cheat_state.loopLine = -1;
-                            }
-                            else
-                            {
-                                if (cheat_state.loopLine != -1)
-                                {
-                                    cheat_state.index = cheat_state.loopLine;
-                                }
-                            }
-                        }
-                        break;
-                    case 0x02:
-                        // D2 Type
-                        // Format: D2000000 00000000
-                        // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
-                        // Simple: ends all lines.
-                        // Example:
-
-                        // 94000130 FEEF0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D2000000 00000000
-
-                        // All lines would terminate.
-                        if (arg1 == 0)
-                        {
-                            if (cheat_state.loopCount > 0)
-                            {
-                                cheat_state.loopCount--;
-                                if (cheat_state.loopCount == 0)
-                                {
-                                    *activeData() = 0;
-                                    *activeOffset() = 0;
-                                    cheat_state.loopLine = -1;
-
-                                    cheat_state.ifStack = 0;
-                                    cheat_state.ifCount = 0;
-                                }
-                                else
-                                {
-                                    if (cheat_state.loopLine != -1)
-                                    {
-                                        cheat_state.index = cheat_state.loopLine;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                *activeData() = 0;
-                                *activeOffset() = 0;
-                                cheat_state.ifStack = 0;
-                                cheat_state.ifCount = 0;
-                            }
-                        }
-                        // D2000000 00000001
-                        // Return
-                        else if (!skipExecution && arg1 == 1)
-                        {
-                            cheat_state.index = cheat->codesCount;
-                        }
-                        break;
-                    case 0x03:
-                        // D3 Type
-                        // Format: D3000000 XXXXXXXX
-                        // Description: sets offset.
-                        // Simple: loads the address X so that lines after can modify the value at address X.
-                        // Note: used with the D4, D5, D6, D7, D8, and DC types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                cheat_state.offset1 = arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.offset2 = arg1;
-                            }
-                        }
-                        break;
-                    case 0x04:
-                        // D4 Type
-                        // Format: D4000000 YYYYYYYY
-                        // Description: adds to the stored address' value.
-                        // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
-                        // Note: used with the D3, D9, DA, DB, DC types.
-                        // Example: D4000000 00000025
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                *activeData() += arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.data1 += arg1 + cheat_state.data2;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                cheat_state.data2 += arg1 + cheat_state.data1;
-                            }
-                        }
-                        break;
-                    case 0x05:
-                        // D5 Type
-                        // Format: D5000000 YYYYYYYY
-                        // Description: sets the stored address' value.
-                        // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
-                        // Note: used with the D3, D9, DA, DB, and DC types.
-                        // Example: D5000000 34540099
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                *activeData() = arg1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                cheat_state.data1 = arg1;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                cheat_state.data2 = arg1;
-                            }
-                        }
-                        break;
-                    case 0x06:
-                        // D6 Type
-                        // Format: D6000000 XXXXXXXX
-                        // Description: 32bit store and increment by 4.
-                        // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
-                        // Note: used with the C, D3, and D9 types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, *activeData())) return 0;
-                                *activeOffset() += 4;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, cheat_state.data1)) return 0;
-                                *activeOffset() += 4;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write32(processHandle, arg1, cheat_state.data2)) return 0;
-                                *activeOffset() += 4;
-                            }
-                        }
-                        break;
-                    case 0x07:
-                        // D7 Type
-                        // Format: D7000000 XXXXXXXX
-                        // Description: 16bit store and increment by 2.
-                        // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
-                        // Note: used with the C, D3, and DA types.
-                        // Example: D7000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (*activeData() & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (cheat_state.data1 & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write16(processHandle, arg1, (u16) (cheat_state.data2 & 0xFFFF))) return 0;
-                                *activeOffset() += 2;
-                            }
-                        }
-                        break;
-                    case 0x08:
-                        // D8 Type
-                        // Format: D8000000 XXXXXXXX
-                        // Description: 8bit store and increment by 1.
-                        // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
-                        // Note: used with the C, D3, and DB types.
-                        // Example: D8000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (*activeData() & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (cheat_state.data1 & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                if (!Cheat_Write8(processHandle, arg1, (u8) (cheat_state.data2 & 0xFF))) return 0;
-                                *activeOffset() += 1;
-                            }
-                        }
-                        break;
-                    case 0x09:
-                        // D9 Type
-                        // Format: D9000000 XXXXXXXX
-                        // Description: 32bit load.
-                        // Simple: loads the value from address X.
-                        // Note: used with the D5 and D6 types.
-                        // Example: D9000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u32 value = 0;
-                                if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
-                            }
-                        }
-                        break;
-                    case 0x0A:
-                        // DA Type
-                        // Format: DA000000 XXXXXXXX
-                        // Description: 16bit load.
-                        // Simple: loads 2 bytes from address X.
-                        // Note: used with the D5 and D7 types.
-                        // Example: DA000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (codeArg == 0)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u16 value = 0;
-                                if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
-                            }
-                        }
-                        break;
-                    case 0x0B:
-                        // DB Type
-                        // Format: DB000000 XXXXXXXX
-                        // Description: 8bit load.
-                        // Simple: loads 1 byte from address X.
-                        // Note: used with the D5 and D8 types.
-                        // Example: DB000000 023D6B28
-                        if (!skipExecution)
+            }
+        }
+    }
+
+    Cheat_PushCondition(newSkip, skipExecution);
+    return true;
+}
+
+static bool Cheat_OpRandom(const Handle processHandle, CheatDescription* const cheat, const CheatOp* op, bool skipExecution)
+{
+    (void)processHandle;
+    (void)cheat;
+    if (!skipExecution)
+    {
+        u32 range = op->value - op->address;
+        u32 number = Cheat_GetRandomNumber() % range;
+        *activeData() = op->address + number;
+    }
+    return true;
+}
+
+static const CheatOpHandler cheatOpHandlers[CHEAT_OP_COUNT] =
+{
+    [CHEAT_OP_INVALID]          = Cheat_OpInvalid,
+    [CHEAT_OP_NOP]              = Cheat_OpNop,
+    [CHEAT_OP_WRITE32]          = Cheat_OpWrite32,
+    [CHEAT_OP_WRITE16]          = Cheat_OpWrite16,
+    [CHEAT_OP_WRITE8]           = Cheat_OpWrite8,
+    [CHEAT_OP_IF32]             = Cheat_OpIf32,
+    [CHEAT_OP_IF16]             = Cheat_OpIf16,
+    [CHEAT_OP_LOAD_OFFSET]      = Cheat_OpLoadOffset,
+    [CHEAT_OP_LOOP]             = Cheat_OpLoop,
+    [CHEAT_OP_END_IF]           = Cheat_OpEndIf,
+    [CHEAT_OP_BREAK]            = Cheat_OpBreak,
+    [CHEAT_OP_END_LOOP]         = Cheat_OpEndLoop,
+    [CHEAT_OP_END_ALL]          = Cheat_OpEndAll,
+    [CHEAT_OP_RETURN]           = Cheat_OpReturn,
+    [CHEAT_OP_SET_OFFSET]       = Cheat_OpSetOffset,
+    [CHEAT_OP_ADD_DATA]         = Cheat_OpAddData,
+    [CHEAT_OP_SET_DATA]         = Cheat_OpSetData,
+    [CHEAT_OP_STORE32]          = Cheat_OpStore32,
+    [CHEAT_OP_STORE16]          = Cheat_OpStore16,
+    [CHEAT_OP_STORE8]           = Cheat_OpStore8,
+    [CHEAT_OP_LOAD32]           = Cheat_OpLoad32,
+    [CHEAT_OP_LOAD16]           = Cheat_OpLoad16,
+    [CHEAT_OP_LOAD8]            = Cheat_OpLoad8,
+    [CHEAT_OP_ADD_OFFSET]       = Cheat_OpAddOffset,
+    [CHEAT_OP_IF_KEYS]          = Cheat_OpIfKeys,
+    [CHEAT_OP_IF_TOUCH]         = Cheat_OpIfTouch,
+    [CHEAT_OP_MOVE_OFFSET]      = Cheat_OpMoveOffset,
+    [CHEAT_OP_MOVE_DATA]        = Cheat_OpMoveData,
+    [CHEAT_OP_MOVE_STORAGE]     = Cheat_OpMoveStorage,
+    [CHEAT_OP_DATA_MODE]        = Cheat_OpDataMode,
+    [CHEAT_OP_CONDITIONAL_MODE] = Cheat_OpConditionalMode,
+    [CHEAT_OP_WRITE_BYTES]      = Cheat_OpWriteBytes,
+    [CHEAT_OP_FLOAT_MODE]       = Cheat_OpFloatMode,
+    [CHEAT_OP_ARITH_MEMORY]     = Cheat_OpArithMemory,
+    [CHEAT_OP_ARITH_DATA]       = Cheat_OpArithData,
+    [CHEAT_OP_COPY_BYTES]       = Cheat_OpCopyBytes,
+    [CHEAT_OP_SEARCH]           = Cheat_OpSearch,
+    [CHEAT_OP_RANDOM]           = Cheat_OpRandom,
+};
+
+static inline CheatOp Cheat_MakeOp(u8 opcode, u8 arg, u32 address, u32 value)
+{
+    return (CheatOp) { .opcode = opcode, .arg = arg, .target = 0, .address = address, .value = value };
+}
+
+static CheatOp Cheat_CompileCode(const CheatDescription* cheat, u32 index)
+{
+    u32 arg0 = (u32) ((cheat->codes[index] >> 32) & 0x00000000FFFFFFFFULL);
+    u32 arg1 = (u32) ((cheat->codes[index]) & 0x00000000FFFFFFFFULL);
+    if (arg0 == 0 && arg1 == 0)
+    {
+        return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+    }
+    u32 code = ((arg0 >> 28) & 0x0F);
+    u32 subcode = ((arg0 >> 24) & 0x0F);
+    u32 codeArg = arg0 & 0x0F;
+
+    switch (code)
+    {
+        case 0x0:
+            // 0 Type
+            // Format: 0XXXXXXX YYYYYYYY
+            // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
+            return Cheat_MakeOp(CHEAT_OP_WRITE32, 0, arg0 & 0x0FFFFFFF, arg1);
+        case 0x1:
+            // 1 Type
+            // Format: 1XXXXXXX 0000YYYY
+            // Description: 16bit write of YYYY to 0XXXXXXX.
+            return Cheat_MakeOp(CHEAT_OP_WRITE16, 0, arg0 & 0x0FFFFFFF, arg1 & 0xFFFF);
+        case 0x2:
+            // 2 Type
+            // Format: 2XXXXXXX 000000YY
+            // Description: 8bit write of YY to 0XXXXXXX.
+            return Cheat_MakeOp(CHEAT_OP_WRITE8, 0, arg0 & 0x0FFFFFFF, arg1 & 0xFF);
+        case 0x3:
+        case 0x4:
+        case 0x5:
+        case 0x6:
+            // 3-6 Types
+            // Format: 3XXXXXXX YYYYYYYY
+            // Description: 32bit if less than (3), greater than (4), equal to (5), not equal to (6).
+            // Simple: If the value at address 0XXXXXXX compares with the value YYYYYYYY.
+            // Example: 323D6B28 10000000
+            return Cheat_MakeOp(CHEAT_OP_IF32, code - 0x3, arg0 & 0x0FFFFFFF, arg1);
+        case 0x7:
+        case 0x8:
+        case 0x9:
+        case 0xA:
+            // 7-A Types
+            // Format: 7XXXXXXX ZZZZYYYY
+            // Description: 16bit if less than (7), greater than (8), equal to (9), not equal to (A).
+            // Simple: If the value at address 0XXXXXXX, masked by ~ZZZZ, compares with the value YYYY.
+            // Example: 723D6B28 00005400
+            return Cheat_MakeOp(CHEAT_OP_IF16, code - 0x7, arg0 & 0x0FFFFFFF, arg1);
+        case 0xB:
+            // B Type
+            // Format: BXXXXXXX 00000000
+            // Description: Loads offset register with value at given XXXXXXX
+            return Cheat_MakeOp(CHEAT_OP_LOAD_OFFSET, 0, arg0 & 0x0FFFFFFF, 0);
+        case 0xC:
+            // C Type
+            // Format: C0000000 ZZZZZZZZ
+            // Description: Repeat following lines at specified offset.
+            // Simple: used to write a value to an address, and then continues to write that value Z number of times to all addresses at an offset determined by the (D6, D7, D8, or DC) type following it.
+            // Note: used with the D6, D7, D8, and DC types. C types can not be nested.
+            // Example:
+
+            // C0000000 00000005
+            // 023D6B28 0009896C
+            // DC000000 00000010
+            // D2000000 00000000
+
+            // C1 and C2 take the count from data1 and data2 respectively
+            return subcode <= 0x02 ? Cheat_MakeOp(CHEAT_OP_LOOP, subcode, 0, arg1) : Cheat_MakeOp(CHEAT_OP_NOP, 0, 0, 0);
+        case 0xD:
+            switch (subcode)
+            {
+                case 0x00:
+                    // D0 Type
+                    // Format: D0000000 00000000
+                    // Description: ends most recent conditional.
+                    // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
+                    // Example:
+
+                    // 94000130 FFFB0000
+                    // 74000100 FF00000C
+                    // 023D6B28 0009896C
+                    // D0000000 00000000
+
+                    // The 7 type line would be terminated.
+                    if (arg1 == 0)
+                    {
+                        return Cheat_MakeOp(CHEAT_OP_END_IF, 0, 0, 0);
+                    }
+                    // D0000000 00000001
+                    // Loop break: resume right after the line following the next D1/D2 terminator
+                    else if (arg1 == 1)
+                    {
+                        CheatOp op = Cheat_MakeOp(CHEAT_OP_BREAK, 0, 0, 0);
+                        u32 target = index + 1;
+                        while (target < cheat->codesCount)
                         {
-                            if (codeArg == 0)
-                            {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                *activeData() = value;
-                            }
-                            else if (codeArg == 1)
+                            u64 code = cheat->codes[target++];
+                            if (code == 0xD100000000000000ull || code == 0xD200000000000000ull)
                             {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                cheat_state.data1 = value;
-                            }
-                            else if (codeArg == 2)
-                            {
-                                u8 value = 0;
-                                if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                                cheat_state.data2 = value;
+                                break;
                             }
                         }
-                        break;
-                    case 0x0C:
-                        // DC Type
-                        // Format: DC000000 VVVVVVVV
-                        // Description: 32bit store and increment by V.
-                        // Simple: stores the value at address(es) before it and to addresses in increments of V.
-                        // Note: used with the C, D3, D5, D9, D8, DB types.
-                        // Example: DC000000 00000100
-                        if (!skipExecution)
-                        {
-                            *activeOffset() += arg1;
-                        }
-                        break;
-                    case 0x0D:
-                        // DD Type
+                        op.target = (u16) target;
+                        return op;
+                    }
+                    return Cheat_MakeOp(CHEAT_OP_NOP, 0, 0, 0);
+                case 0x01:
+                    // D1 Type
+                    // Format: D1000000 00000000
+                    // Description: ends repeat block.
+                    // Simple: will end all conditionals within a C type code, along with the C type itself.
+                    // Example:
+
+                    // 94000130 FFFB0000
+                    // C0000000 00000010
+                    // 8453DA0C 00000200
+                    // 023D6B28 0009896C
+                    // D6000000 00000005
+                    // D1000000 00000000
+
+                    // The C line, 8 line, 0 line, and D6 line would be terminated.
+                    return Cheat_MakeOp(CHEAT_OP_END_LOOP, 0, 0, 0);
+                case 0x02:
+                    // D2 Type
+                    // Format: D2000000 00000000
+                    // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
+                    // Simple: ends all lines.
+                    // Example:
+
+                    // 94000130 FEEF0000
+                    // C0000000 00000010
+                    // 8453DA0C 00000200
+                    // 023D6B28 0009896C
+                    // D6000000 00000005
+                    // D2000000 00000000
+
+                    // All lines would terminate.
+                    if (arg1 == 0)
                     {
-                        bool newSkip = !(arg1 == 0 || (HID_PAD & arg1) == arg1);
-
-                        cheat_state.ifStack <<= 1;
-                        cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;;
-                        cheat_state.ifCount++;
+                        return Cheat_MakeOp(CHEAT_OP_END_ALL, 0, 0, 0);
                     }
-                        break;
-                    case 0x0E:
-                        // Touchpad conditional
-                        // DE000000 AAAABBBB: AAAA >= X position >= BBBB
-                        // DE000001 AAAABBBB: AAAA >= Y position >= BBBB
+                    // D2000000 00000001
+                    // Return
+                    else if (arg1 == 1)
                     {
-                        bool newSkip;
-                        u32 highBound = arg1 >> 16;
-                        u32 lowBound = arg1 & 0xFFFF;
-                        touchPosition touch;
-                        hidTouchRead(&touch);
-                        if (codeArg == 0)
-                        {
-                            newSkip = !(lowBound <= touch.px && highBound >= touch.px);
-                        }
-                        else if (codeArg == 1)
-                        {
-                            newSkip = !(lowBound <= touch.py && highBound >= touch.py);
-                        }
-                        else
-                        {
-                            return 0;
-                        }
-
-                        cheat_state.ifStack <<= 1;
-                        cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                        cheat_state.ifCount++;
+                        return Cheat_MakeOp(CHEAT_OP_RETURN, 0, 0, 0);
                     }
-                        break;
-                    case 0x0F:
+                    return Cheat_MakeOp(CHEAT_OP_NOP, 0, 0, 0);
+                case 0x03:
+                    // D3 Type
+                    // Format: D3000000 XXXXXXXX
+                    // Description: sets offset.
+                    // Simple: loads the address X so that lines after can modify the value at address X.
+                    // Note: used with the D4, D5, D6, D7, D8, and DC types.
+                    // Example: D3000000 023D6B28
+                    return codeArg <= 1 ? Cheat_MakeOp(CHEAT_OP_SET_OFFSET, codeArg, 0, arg1) : Cheat_MakeOp(CHEAT_OP_NOP, 0, 0, 0);
+                case 0x04:
+                    // D4 Type
+                    // Format: D4000000 YYYYYYYY
+                    // Description: adds to the stored address' value.
+                    // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
+                    // Note: used with the D3, D9, DA, DB, DC types.
+                    // Example: D4000000 00000025
+                case 0x05:
+                    // D5 Type
+                    // Format: D5000000 YYYYYYYY
+                    // Description: sets the stored address' value.
+                    // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
+                    // Note: used with the D3, D9, DA, DB, and DC types.
+                    // Example: D5000000 34540099
+                case 0x06:
+                    // D6 Type
+                    // Format: D6000000 XXXXXXXX
+                    // Description: 32bit store and increment by 4.
+                    // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
+                    // Note: used with the C, D3, and D9 types.
+                    // Example: D3000000 023D6B28
+                case 0x07:
+                    // D7 Type
+                    // Format: D7000000 XXXXXXXX
+                    // Description: 16bit store and increment by 2.
+                    // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
+                    // Note: used with the C, D3, and DA types.
+                    // Example: D7000000 023D6B28
+                case 0x08:
+                    // D8 Type
+                    // Format: D8000000 XXXXXXXX
+                    // Description: 8bit store and increment by 1.
+                    // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
+                    // Note: used with the C, D3, and DB types.
+                    // Example: D8000000 023D6B28
+                case 0x09:
+                    // D9 Type
+                    // Format: D9000000 XXXXXXXX
+                    // Description: 32bit load.
+                    // Simple: loads the value from address X.
+                    // Note: used with the D5 and D6 types.
+                    // Example: D9000000 023D6B28
+                case 0x0A:
+                    // DA Type
+                    // Format: DA000000 XXXXXXXX
+                    // Description: 16bit load.
+                    // Simple: loads 2 bytes from address X.
+                    // Note: used with the D5 and D7 types.
+                    // Example: DA000000 023D6B28
+                case 0x0B:
+                    // DB Type
+                    // Format: DB000000 XXXXXXXX
+                    // Description: 8bit load.
+                    // Simple: loads 1 byte from address X.
+                    // Note: used with the D5 and D8 types.
+                    // Example: DB000000 023D6B28
+
+                    // The low nibble selects the active data register (0), data1 (1) or data2 (2)
+                    if (codeArg > 2)
                     {
-                        switch (codeArg)
-                        {
-                            case 0x00:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.offset2 = cheat_state.offset1;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.offset1 = cheat_state.offset2;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat_state.offset2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat_state.offset1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat_state.activeOffset = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x01:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat_state.data1;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat_state.data2;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.offset2 = cheat_state.data2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.offset1 = cheat_state.data1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat_state.activeData = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x02:
-                            {
-                                if (arg1 & 0x00010000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat_state.data2 = cheat->storage2;
-                                    }
-                                    else
-                                    {
-                                        cheat_state.data1 = cheat->storage1;
-                                    }
-                                }
-                                else if (arg1 & 0x00020000)
-                                {
-                                    if (arg1 & 0x1)
-                                    {
-                                        cheat->storage2 = cheat_state.data2;
-                                    }
-                                    else
-                                    {
-                                        cheat->storage1 = cheat_state.data1;
-                                    }
-                                }
-                                else
-                                {
-                                    cheat->activeStorage = arg1 & 0x1;
-                                }
-                            }
-                                break;
-                            case 0x0E:
-                            {
-                                if (cheat_state.activeData)
-                                {
-                                    switch (arg1)
-                                    {
-                                        case 0x0:
-                                        {
-                                            cheat_state.data2Mode = 0;
-                                        }
-                                            break;
-                                        case 0x1:
-                                        {
-                                            cheat_state.data2Mode = 1;
-                                        }
-                                            break;
-                                        case 0x10:
-                                        {
-                                            cheat_state.data2Mode = 0;
-                                            float val;
-                                            memcpy(&val, &cheat_state.data2, sizeof(float));
-                                            cheat_state.data2 = val;
-                                        }
-                                            break;
-                                        case 0x11:
-                                        {
-                                            cheat_state.data2Mode = 1;
-                                            float val = cheat_state.data2;
-                                            memcpy(&cheat_state.data2, &val, sizeof(float));
-                                        }
-                                            break;
-                                        default:
-                                            return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    switch (arg1)
-                                    {
-                                        case 0x0:
-                                        {
-                                            cheat_state.data1Mode = 0;
-                                        }
-                                            break;
-                                        case 0x1:
-                                        {
-                                            cheat_state.data1Mode = 1;
-                                        }
-                                            break;
-                                        case 0x10:
-                                        {
-                                            cheat_state.data1Mode = 0;
-                                            float val;
-                                            memcpy(&val, &cheat_state.data1, sizeof(float));
-                                            cheat_state.data1 = val;
-                                        }
-                                            break;
-                                        case 0x11:
-                                        {
-                                            cheat_state.data1Mode = 1;
-                                            float val = cheat_state.data1;
-                                            memcpy(&cheat_state.data1, &val, sizeof(float));
-                                        }
-                                            break;
-                                        default:
-                                            return 0;
-                                    }
-                                }
-                            }
-                                break;
-                            case 0x0F:
+                        return Cheat_MakeOp(CHEAT_OP_NOP, 0, 0, 0);
+                    }
+                    return Cheat_MakeOp(CHEAT_OP_ADD_DATA + (subcode - 0x04), codeArg, 0, arg1);
+                case 0x0C:
+                    // DC Type
+                    // Format: DC000000 VVVVVVVV
+                    // Description: 32bit store and increment by V.
+                    // Simple: stores the value at address(es) before it and to addresses in increments of V.
+                    // Note: used with the C, D3, D5, D9, D8, DB types.
+                    // Example: DC000000 00000100
+                    return Cheat_MakeOp(CHEAT_OP_ADD_OFFSET, 0, 0, arg1);
+                case 0x0D:
+                    // DD Type
+                    return Cheat_MakeOp(CHEAT_OP_IF_KEYS, 0, 0, arg1);
+                case 0x0E:
+                    // Touchpad conditional
+                    // DE000000 AAAABBBB: AAAA >= X position >= BBBB
+                    // DE000001 AAAABBBB: AAAA >= Y position >= BBBB
+                    return codeArg <= 1 ? Cheat_MakeOp(CHEAT_OP_IF_TOUCH, codeArg, 0, arg1) : Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+                case 0x0F:
+                    switch (codeArg)
+                    {
+                        case 0x00:
+                            return Cheat_MakeOp(CHEAT_OP_MOVE_OFFSET, 0, 0, arg1);
+                        case 0x01:
+                            return Cheat_MakeOp(CHEAT_OP_MOVE_DATA, 0, 0, arg1);
+                        case 0x02:
+                            return Cheat_MakeOp(CHEAT_OP_MOVE_STORAGE, 0, 0, arg1);
+                        case 0x0E:
+                            // 0/1: integer/float mode, 0x10/0x11: also convert the register
+                            if (arg1 == 0x0 || arg1 == 0x1 || arg1 == 0x10 || arg1 == 0x11)
                             {
-                                if (arg1 < 5)
-                                {
-                                    cheat_state.conditionalMode = (u8)arg1;
-                                }
-                                else
-                                {
-                                    return 0;
-                                }
+                                return Cheat_MakeOp(CHEAT_OP_DATA_MODE, 0, 0, arg1);
                             }
-                                break;
-                            default:
-                                return 0;
-                        }
+                            return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+                        case 0x0F:
+                            return arg1 < 5 ? Cheat_MakeOp(CHEAT_OP_CONDITIONAL_MODE, (u8)arg1, 0, 0) : Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+                        default:
+                            return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
                     }
-                        break;
-                    default:
-                        return 0;
-                }
-                break;
-            case 0xE:
-                // E Type
-                // Format:
-                // EXXXXXXX UUUUUUUU
-                // YYYYYYYY YYYYYYYY
-
-                // Description: writes Y to X for U bytes.
-
+                default:
+                    return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+            }
+        case 0xE:
+        {
+            // E Type
+            // Format:
+            // EXXXXXXX UUUUUUUU
+            // YYYYYYYY YYYYYYYY
+
+            // Description: writes Y to X for U bytes.
+            u64 lastLine = (u64)index + ((u64)arg1 + 7) / 8;
+            if (lastLine >= cheat->codesCount)
             {
-                u32 beginOffset = (arg0 & 0x0FFFFFFF);
-                u32 count = arg1;
-                cheat_state.typeELine = cheat_state.index;
-                cheat_state.typeEIdx = 7;
-                for (u32 i = 0; i < count; i++)
-                {
-                    u8 byte = Cheat_GetNextTypeE(cheat);
-                    if (!skipExecution)
-                    {
-                        if (!Cheat_Write8(processHandle, beginOffset + i, byte)) return 0;
-                    }
-                }
-                cheat_state.index = cheat_state.typeELine;
+                return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
             }
-                break;
-            case 0xF:
+            CheatOp op = Cheat_MakeOp(CHEAT_OP_WRITE_BYTES, 0, arg0 & 0x0FFFFFFF, arg1);
+            op.target = (u16) lastLine;
+            return op;
+        }
+        case 0xF:
+        {
+            if (arg0 == 0xF0F00000)
             {
-                if (arg0 == 0xF0F00000)
-                {
-                    // I have no clue how to implement this, or if it's even possible. Needs research.
-                    return 0;
-                }
-                else
+                // I have no clue how to implement this, or if it's even possible. Needs research.
+                return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+            }
+
+            switch (subcode)
+            {
+                case 0x0:
+                    return Cheat_MakeOp(CHEAT_OP_FLOAT_MODE, 0, 0, arg1);
+                case 0x1:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_MEMORY, CHEAT_ARITH_ADD, arg0 & 0x00FFFFFF, arg1);
+                case 0x2:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_MEMORY, CHEAT_ARITH_MUL, arg0 & 0x00FFFFFF, arg1);
+                case 0x3:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_MEMORY, CHEAT_ARITH_DIV, arg0 & 0x00FFFFFF, arg1);
+                case 0x4:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_MUL, 0, arg1);
+                case 0x5:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_DIV, 0, arg1);
+                case 0x6:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_AND, 0, arg1);
+                case 0x7:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_OR, 0, arg1);
+                case 0x8:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_XOR, 0, arg1);
+                case 0x9:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_NOT, 0, arg1);
+                case 0xA:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_SHL, 0, arg1);
+                case 0xB:
+                    return Cheat_MakeOp(CHEAT_OP_ARITH_DATA, CHEAT_ARITH_SHR, 0, arg1);
+                case 0xC:
+                    return Cheat_MakeOp(CHEAT_OP_COPY_BYTES, 0, 0, arg1);
+                // Search for pattern
+                case 0xE:
                 {
-                    switch (subcode)
+                    u32 searchSize = arg0 & 0xFFFF;
+                    if (searchSize <= arg1 && searchSize + index < cheat->codesCount)
                     {
-                        case 0x0:
-                        {
-                            if(!skipExecution)
-                            {
-                                cheat_state.floatMode = arg1 & 0x1;
-                            }
-                        }
-                            break;
-                        case 0x1:
-                        {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value += flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp += arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
-                        }
-                            break;
-                        case 0x2:
-                        {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value *= flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp *= arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
-                        }
-                            break;
-                        case 0x3:
-                        {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.floatMode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    float value;
-                                    memcpy(&value, &tmp, sizeof(float));
-                                    value /= flarg1;
-                                    memcpy(&tmp, &value, sizeof(u32));
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                else
-                                {
-                                    u32 tmp;
-                                    if (!Cheat_Read32(processHandle, arg0 & 0x00FFFFFF, &tmp))
-                                    {
-                                        return 0;
-                                    }
-                                    tmp /= arg1;
-                                    if (!Cheat_Write32(processHandle, arg0 & 0x00FFFFFF, tmp))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                            }
-                        }
-                            break;
-                        case 0x4:
-                        {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.data1Mode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    float value;
-                                    memcpy(&value, activeData(), sizeof(float));
-                                    value *= flarg1;
-                                    memcpy(activeData(), &value, sizeof(float));
-                                }
-                                else
-                                {
-                                    *activeData() *= arg1;
-                                }
-                            }
-                        }
-                            break;
-                        case 0x5:
-                        {
-                            if (!skipExecution)
-                            {
-                                if (cheat_state.data1Mode)
-                                {
-                                    float flarg1;
-                                    memcpy(&flarg1, &arg1, sizeof(float));
-                                    float value;
-                                    memcpy(&value, activeData(), sizeof(float));
-                                    value /= flarg1;
-                                    memcpy(activeData(), &value, sizeof(float));
-                                }
-                                else
-                                {
-                                    *activeData() /= arg1;
-                                }
-                            }
-                        }
-                            break;
-                        case 0x6:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() &= arg1;
-                            }
-                        }
-                            break;
-                        case 0x7:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() |= arg1;
-                            }
-                        }
-                            break;
-                        case 0x8:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() ^= arg1;
-                            }
-                        }
-                            break;
-                        case 0x9:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() = ~*activeData();
-                            }
-                        }
-                            break;
-                        case 0xA:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() <<= arg1;
-                            }
-                        }
-                            break;
-                        case 0xB:
-                        {
-                            if (!skipExecution)
-                            {
-                                *activeData() >>= arg1;
-                            }
-                        }
-                            break;
-                        case 0xC:
-                        {
-                            if (!skipExecution)
-                            {
-                                u8 origActiveOffset = cheat_state.activeOffset;
-                                for (size_t i = 0; i < arg1; i++)
-                                {
-                                    u8 data;
-                                    cheat_state.activeOffset = 1;
-                                    if (!Cheat_Read8(processHandle, 0, &data))
-                                    {
-                                        return 0;
-                                    }
-                                    cheat_state.activeOffset = 0;
-                                    if (!Cheat_Write8(processHandle, 0, data))
-                                    {
-                                        return 0;
-                                    }
-                                }
-                                cheat_state.activeOffset = origActiveOffset;
-                            }
-                        }
-                            break;
-                        // Search for pattern
-                        case 0xE:
-                        {
-                            u32 searchSize = arg0 & 0xFFFF;
-                            if (searchSize <= arg1 && searchSize + cheat_state.index < cheat->codesCount)
-                            {
-                                bool newSkip = true;
-                                if (!skipExecution) // Don't do an expensive operation if we don't have to
-                                {
-                                    u8* searchData = (u8*)(cheat->codes + cheat_state.index + 1);
-                                    cheat_state.index += searchSize / 8;
-                                    if (searchSize & 0x7)
-                                    {
-                                        cheat_state.index++;
-                                    }
-                                    for (size_t i = 0; i < arg1 - searchSize; i++)
-                                    {
-                                        u8 curVal;
-                                        newSkip = false;
-                                        for (size_t j = 0; j < searchSize; j++)
-                                        {
-                                            if (!Cheat_Read8(processHandle, i + j, &curVal))
-                                            {
-                                                return 0;
-                                            }
-                                            if (curVal != searchData[j])
-                                            {
-                                                newSkip = 1;
-                                                break;
-                                            }
-                                        }
-                                        if (!newSkip)
-                                        {
-                                            break;
-                                        }
-                                    }
-                                }
-
-                                cheat_state.ifStack <<= 1;
-                                cheat_state.ifStack |= (newSkip || skipExecution) ? 1 : 0;
-                                cheat_state.ifCount++;
-                            }
-                            else
-                            {
-                                return 0;
-                            }
-                        }
-                            break;
-                        case 0xF:
-                        {
-                            if (!skipExecution)
-                            {
-                                u32 range = arg1 - (arg0 & 0xFFFFFF);
-                                u32 number = Cheat_GetRandomNumber() % range;
-                                *activeData() = (arg0 & 0xFFFFFF) + number;
-                            }
-                        }
-                            break;
-                        default:
-                            return 0;
+                        CheatOp op = Cheat_MakeOp(CHEAT_OP_SEARCH, 0, searchSize, arg1);
+                        op.target = (u16) (index + (searchSize + 7) / 8);
+                        return op;
                     }
+                    return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
                 }
+                case 0xF:
+                    return Cheat_MakeOp(CHEAT_OP_RANDOM, 0, arg0 & 0x00FFFFFF, arg1);
+                default:
+                    return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
             }
-                break;
-            // This should now not be possible
-            default:
-                return 0;
+        }
+        // This should now not be possible
+        default:
+            return Cheat_MakeOp(CHEAT_OP_INVALID, 0, 0, 0);
+    }
+}
+
+static void Cheat_CompileCheat(CheatDescription* cheat, CheatOp* ops)
+{
+    cheat->ops = ops;
+    for (u32 i = 0; i < cheat->codesCount; i++)
+    {
+        ops[i] = Cheat_CompileCode(cheat, i);
+    }
+}
+
+static u32 Cheat_ApplyCheat(const Handle processHandle, CheatDescription* const cheat)
+{
+    cheat_state.index = 0;
+    cheat_state.offset1 = 0;
+    cheat_state.offset2 = 0;
+    cheat_state.data1 = 0;
+    cheat_state.data2 = 0;
+    cheat_state.activeOffset = 0;
+    cheat_state.activeData = 0;
+    cheat_state.conditionalMode = 0;
+    cheat_state.data1Mode = 0;
+    cheat_state.data2Mode = 0;
+    cheat_state.floatMode = 0;
+    cheat_state.loopCount = 0;
+    cheat_state.loopLine = -1;
+    cheat_state.ifStack = 0;
+    cheat_state.storedStack = 0;
+    cheat_state.ifCount = 0;
+    cheat_state.storedIfCount = 0;
+
+    while (cheat_state.index < cheat->codesCount)
+    {
+        const CheatOp* op = &cheat->ops[cheat_state.index];
+        bool skipExecution = (cheat_state.ifStack & 0x00000001) != 0;
+        if (!cheatOpHandlers[op->opcode](processHandle, cheat, op, skipExecution))
+        {
+            return 0;
         }
         cheat_state.index++;
     }
@@ -1633,115 +1779,171 @@ static void Cheat_EatEvents(Handle debug)
     }
 }
 
-static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
+static Result Cheat_BeginSession(u32 pid, Handle* debugHandle)
 {
-    Handle processHandle;
-    Handle debugHandle;
-    Result res;
-    res = svcOpenProcess(&processHandle, pid);
-    if (R_SUCCEEDED(res))
+    Result res = svcOpenProcess(&cheatProcessHandle, pid);
+    if (R_FAILED(res))
     {
-        res = svcDebugActiveProcess(&debugHandle, pid);
-        if (R_SUCCEEDED(res))
-        {
-            Cheat_EatEvents(debugHandle);
-            cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
+        sprintf(failureReason, "Proceso abierto fallo");
+        cheatProcessHandle = 0;
+        return res;
+    }
 
-            svcCloseHandle(debugHandle);
-            svcCloseHandle(processHandle);
-            cheat->active = 1;
-        }
-        else
+    res = svcDebugActiveProcess(debugHandle, pid);
+    if (R_FAILED(res))
+    {
+        sprintf(failureReason, "Proceso de debug fallo");
+        svcCloseHandle(cheatProcessHandle);
+        cheatProcessHandle = 0;
+        return res;
+    }
+
+    if (pid != cheatRegionsPid)
+    {
+        cheatRegionsPid = pid;
+        cheatRegionCount = 0;
+    }
+
+    // note: mappableFree doesn't do anything, so the window is reserved once and kept
+    if (cheatMapWindow == 0)
+    {
+        cheatMapWindow = (u32)mappableAlloc(CHEAT_MAPPED_PAGE_COUNT * 0x1000);
+    }
+
+    Cheat_EatEvents(*debugHandle);
+    return res;
+}
+
+static void Cheat_EndSession(Handle debugHandle)
+{
+    if (cheatMappedWrites)
+    {
+        // Cheats may patch code
+        svcFlushEntireDataCache();
+        svcInvalidateEntireInstructionCache();
+        cheatMappedWrites = false;
+    }
+
+    for (u32 i = 0; i < CHEAT_MAPPED_PAGE_COUNT; i++)
+    {
+        if (cheatMappedPages[i].mapped)
         {
-            sprintf(failureReason, "Proceso de debug fallo");
-            svcCloseHandle(processHandle);
+            svcUnmapProcessMemoryEx(CUR_PROCESS_HANDLE, cheatMapWindow + i * 0x1000, 0x1000);
         }
+        cheatMappedPages[i].address = 0;
+        cheatMappedPages[i].mapped = false;
     }
-    else
+
+    svcCloseHandle(debugHandle);
+    svcCloseHandle(cheatProcessHandle);
+    cheatProcessHandle = 0;
+}
+
+static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
+{
+    Handle debugHandle;
+    Result res = Cheat_BeginSession(pid, &debugHandle);
+    if (R_SUCCEEDED(res))
     {
-        sprintf(failureReason, "Proceso abierto fallo");
+        cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
+        Cheat_EndSession(debugHandle);
+        cheat->active = 1;
+        cheat->nextFrame = cheatFrame + cheat->periodFrames;
     }
     return res;
 }
 
-static CheatDescription* Cheat_AllocCheat()
+static u16 Cheat_MsToFrames(u32 ms)
+{
+    u64 frames = (1000 * 1000ULL * ms + CHEAT_FRAME_PERIOD_NS - 1) / CHEAT_FRAME_PERIOD_NS;
+    return frames == 0 ? 1 : (frames > 0xFFFF ? 0xFFFF : (u16)frames);
+}
+
+// Commits the pages needed for the first size bytes of the arena
+static bool Cheat_ReserveMemory(CheatArena* arena, u32 size)
 {
-    CheatDescription* cheat;
-    if (cheatCount == 0)
+    if (size <= arena->size)
     {
-        cheat = (CheatDescription*) cheatBuffer;
+        return true;
     }
-    else
+    if (size > arena->maxSize)
+    {
+        return false;
+    }
+
+    u32 tmp;
+    u32 newSize = (size + 0xFFF) & ~0xFFF;
+    if (R_FAILED(svcControlMemoryEx(&tmp, arena->base + arena->size, 0, newSize - arena->size, MEMOP_ALLOC, MEMREGION_SYSTEM | MEMPERM_READWRITE, true)))
+    {
+        return false;
+    }
+
+    arena->size = newSize;
+    return true;
+}
+
+static void Cheat_FreeMemory(CheatArena* arena)
+{
+    u32 tmp;
+    if (arena->size != 0)
+    {
+        svcControlMemory(&tmp, arena->base, 0, arena->size, MEMOP_FREE, 0);
+    }
+    arena->size = 0;
+}
+
+static void Cheat_FreeAllMemory(void)
+{
+    cheatCount = 0;
+    cheatLoadedCodes = 0;
+    Cheat_FreeMemory(&cheatListArena);
+    Cheat_FreeMemory(&cheatCodesArena);
+    Cheat_FreeMemory(&cheatOpsArena);
+}
+
+// Returns NULL when no more cheats fit in memory
+static CheatDescription* Cheat_AllocCheat()
+{
+    if (!Cheat_ReserveMemory(&cheatListArena, (cheatCount + 1) * sizeof(CheatDescription)))
     {
-        CheatDescription* prev = cheats[cheatCount - 1];
-        cheat = (CheatDescription *) ((u8*) (prev) + sizeof(CheatDescription) + sizeof(u64) * (prev->codesCount));
+        return NULL;
     }
+
+    CheatDescription* cheat = &cheats[cheatCount++];
     cheat->active = 0;
     cheat->valid = 1;
     cheat->codesCount = 0;
     cheat->hasKeyCode = 0;
+    cheat->activeStorage = 0;
     cheat->storage1 = 0;
     cheat->storage2 = 0;
+    cheat->ops = NULL;
+    cheat->periodFrames = Cheat_MsToFrames(CHEAT_DEFAULT_PERIOD_MS);
+    cheat->priority = 0;
+    cheat->nextFrame = 0;
+    cheat->codesIndex = 0;
+    cheat->codes = NULL;
     cheat->name[0] = '\0';
-
-    cheats[cheatCount] = cheat;
-    cheatCount++;
     return cheat;
 }
 
-static void Cheat_AddCode(CheatDescription* cheat, u64 code)
+static Result BufferedFile_Open(BufferedFile* file, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 flags)
 {
-    if (cheat)
-    {
-        cheat->codes[cheat->codesCount] = code;
-        (cheat->codesCount)++;
-    }
+    file->curPos = 0;
+    file->maxPos = 0;
+    return IFile_Open(&file->file, archiveId, archivePath, filePath, flags);
 }
 
-static Result BufferedFile_Open(BufferedFile* file, FS_ArchiveID archiveId, FS_Path archivePath, FS_Path filePath, u32 flags)
+static void BufferedFile_Seek(BufferedFile* file, u64 pos)
 {
-    Result res = 0;
-    memset(file->buffer, '\0', sizeof(file->buffer));
-    res = IFile_Open(&file->file, archiveId, archivePath, filePath, flags);
-    if (R_SUCCEEDED(res))
-    {
-        file->curPos = 0;
-        res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
-    }
-    return res;
+    file->file.pos = pos;
+    file->curPos = 0;
+    file->maxPos = 0;
 }
 
-static Result BufferedFile_Read(BufferedFile* file, u64* totalRead, void* buffer, u32 len)
+static inline u64 BufferedFile_Tell(const BufferedFile* file)
 {
-    Result res = 0;
-    if (len == 0)
-    {
-        *totalRead = 0;
-        return 0;
-    }
-    else if (file->curPos + len < file->maxPos)
-    {
-        memcpy(buffer, file->buffer + file->curPos, len);
-        file->curPos += len;
-        *totalRead = len;
-    }
-    else
-    {
-        *totalRead = 0;
-        while(R_SUCCEEDED(res) && file->maxPos != 0 && *totalRead < len)
-        {
-            u32 toRead = file->maxPos - file->curPos < len - *totalRead ? file->maxPos - file->curPos : len - *totalRead;
-            memcpy(buffer + *totalRead, file->buffer + file->curPos, toRead);
-            *totalRead += toRead;
-            file->curPos += toRead;
-            if (file->curPos >= file->maxPos)
-            {
-                res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
-                file->curPos = 0;
-            }
-        }
-    }
-    return res;
+    return file->file.pos - file->maxPos + file->curPos;
 }
 
 static Result Cheat_ReadLine(BufferedFile* file, char* line, u32 lineSize)
@@ -1749,45 +1951,51 @@ static Result Cheat_ReadLine(BufferedFile* file, char* line, u32 lineSize)
     Result res = 0;
 
     u32 idx = 0;
-    u64 total = 0;
     bool lastWasCarriageReturn = false;
-    while (R_SUCCEEDED(res) && idx < lineSize)
+    while (idx < lineSize)
     {
-        res = BufferedFile_Read(file, &total, line + idx, 1);
-        if (total == 0)
-        {
-            line[idx] = '\0';
-            return -1;
-        }
-        if (R_SUCCEEDED(res))
+        if (file->curPos >= file->maxPos)
         {
-            if (line[idx] == '\r')
+            file->curPos = 0;
+            res = IFile_Read(&file->file, &file->maxPos, file->buffer, sizeof(file->buffer));
+            if (R_FAILED(res))
             {
-                lastWasCarriageReturn = true;
+                break;
             }
-            else if (line[idx] == '\n')
+            if (file->maxPos == 0)
             {
-                if (lastWasCarriageReturn)
-                {
-                    line[--idx] = '\0';
-                    return idx;
-                }
-                else
-                {
-                    line[idx] = '\0';
-                    return idx;
-                }
+                line[idx] = '\0';
+                return -1;
             }
-            else if (line[idx] == '\0')
+        }
+
+        line[idx] = file->buffer[file->curPos++];
+        if (line[idx] == '\r')
+        {
+            lastWasCarriageReturn = true;
+        }
+        else if (line[idx] == '\n')
+        {
+            if (lastWasCarriageReturn)
             {
-                return -1;
+                line[--idx] = '\0';
+                return idx;
             }
             else
             {
-                lastWasCarriageReturn = false;
+                line[idx] = '\0';
+                return idx;
             }
-            idx++;
         }
+        else if (line[idx] == '\0')
+        {
+            return -1;
+        }
+        else
+        {
+            lastWasCarriageReturn = false;
+        }
+        idx++;
     }
     return res;
 }
@@ -1873,6 +2081,60 @@ static u64 Cheat_GetCode(const char *line)
     return tmp;
 }
 
+// Optional schedule at the end of a cheat name: "{frame}", "{once}" or "{<N>ms}", optionally
+// followed by ",prio=<0-7>". Higher priorities run first.
+static void Cheat_ParseSchedule(CheatDescription* cheat, char* name)
+{
+    size_t len = strlen(name);
+    char* tag = strrchr(name, '{');
+    if (tag == NULL || name[len - 1] != '}')
+    {
+        return;
+    }
+
+    name[len - 1] = '\0';
+    char* token = tag + 1;
+    while (token != NULL)
+    {
+        char* next = strchr(token, ',');
+        if (next != NULL)
+        {
+            *next++ = '\0';
+        }
+
+        char* unit;
+        if (strcmp(token, "frame") == 0)
+        {
+            cheat->periodFrames = 1;
+        }
+        else if (strcmp(token, "once") == 0)
+        {
+            cheat->periodFrames = CHEAT_PERIOD_ONCE;
+        }
+        else if (strncmp(token, "prio=", 5) == 0)
+        {
+            u32 priority = strtoul(token + 5, NULL, 10);
+            cheat->priority = priority > CHEAT_MAX_PRIORITY ? CHEAT_MAX_PRIORITY : priority;
+        }
+        else
+        {
+            u32 ms = strtoul(token, &unit, 10);
+            if (unit != token && strcmp(unit, "ms") == 0)
+            {
+                cheat->periodFrames = Cheat_MsToFrames(ms);
+            }
+        }
+        token = next;
+    }
+
+    // Drop the tag from the displayed name
+    *tag = '\0';
+    while (tag > name && (tag[-1] == ' ' || tag[-1] == '\t'))
+    {
+        *--tag = '\0';
+    }
+}
+
 static char* stripWhitespace(char* in)
 {
     char* ret = in;
@@ -1889,35 +2151,118 @@ static char* stripWhitespace(char* in)
     return ret;
 }
 
-static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+static bool Cheat_WriteDatabase(IFile* db, const void* data, u32 size)
 {
-    cheatCount = 0;
-    cheatTitleInfo = titleId;
+    u64 total;
+    return R_SUCCEEDED(IFile_Write(db, &total, data, size, 0)) && total == size;
+}
 
-    char path[64] = { 0 };
-    sprintf(path, "/luma/titles/%016llX/cheats.txt", titleId);
+// Last modification time of a file on the SD card, or 0 if it can't be read
+static u64 Cheat_GetFileTime(const char* path)
+{
+    FS_Archive archive;
+    u16 path16[64];
+    u64 time = 0;
 
-    BufferedFile file;
+    ssize_t units = utf8_to_utf16(path16, (const u8*) path, sizeof(path16) / sizeof(u16) - 1);
+    if (units < 0 || R_FAILED(FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""))))
+    {
+        return 0;
+    }
 
-    if (R_FAILED(BufferedFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    path16[units] = 0;
+    if (R_FAILED(FSUSER_ControlArchive(archive, ARCHIVE_ACTION_GET_TIMESTAMP, path16, 2 * (units + 1), &time, sizeof(time))))
     {
-        // OK, let's try another source
-        sprintf(path, "/cheats/%016llX.txt", titleId);
-        if (R_FAILED(BufferedFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ))) return;
-    };
+        time = 0;
+    }
+
+    FSUSER_CloseArchive(archive);
+    return time;
+}
+
+// The database has to match the size and modification time of its cheats.txt, if there is one.
+// An unknown modification time never matches.
+static bool Cheat_OpenDatabase(const char* path, bool hasText, u64 sourceSize, u64 sourceTime)
+{
+    IFile db;
+    CheatDbHeader header = { 0 };
+    u64 total;
+
+    if (R_FAILED(IFile_Open(&db, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    {
+        return false;
+    }
+
+    bool ok = R_SUCCEEDED(IFile_Read(&db, &total, &header, sizeof(header))) && total == sizeof(header) &&
+        header.magic == CHEAT_DB_MAGIC && header.version == CHEAT_DB_VERSION && header.cheatCount <= CHEAT_MAX_CHEATS &&
+        (!hasText || (header.sourceSize == sourceSize && sourceTime != 0 && header.sourceTime == sourceTime)) &&
+        Cheat_ReserveMemory(&cheatListArena, header.cheatCount * sizeof(CheatDescription)) &&
+        Cheat_ReserveMemory(&cheatCodesArena, CHEAT_STAGING_SIZE);
+
+    // No cheat is enabled yet, so the code buffer is free to read the index through
+    CheatDbEntry* entries = (CheatDbEntry*) cheatCodes;
+    const u32 entriesPerRead = CHEAT_STAGING_SIZE / sizeof(CheatDbEntry);
+    db.pos = header.indexOffset;
+    for (u32 i = 0; ok && i < header.cheatCount; i += entriesPerRead)
+    {
+        u32 count = header.cheatCount - i < entriesPerRead ? header.cheatCount - i : entriesPerRead;
+        ok = R_SUCCEEDED(IFile_Read(&db, &total, entries, count * sizeof(CheatDbEntry))) && total == count * sizeof(CheatDbEntry);
+        for (u32 j = 0; ok && j < count; j++)
+        {
+            CheatDescription* cheat = Cheat_AllocCheat();
+            memcpy(cheat->name, entries[j].name, sizeof(cheat->name));
+            cheat->name[sizeof(cheat->name) - 1] = '\0';
+            cheat->hasKeyCode = (entries[j].flags & CHEAT_DB_FLAG_KEYCODE) != 0;
+            cheat->codesIndex = entries[j].codesIndex;
+            cheat->codesCount = entries[j].codesCount;
+            cheat->periodFrames = entries[j].periodFrames;
+            cheat->priority = entries[j].priority > CHEAT_MAX_PRIORITY ? CHEAT_MAX_PRIORITY : entries[j].priority;
+            ok = cheat->codesIndex + cheat->codesCount <= header.codesCount;
+        }
+    }
+
+    IFile_Close(&db);
+
+    if (!ok)
+    {
+        cheatCount = 0;
+        return false;
+    }
+
+    strcpy(cheatDbPath, path);
+    cheatDbIsBinary = true;
+    cheatDbCodesOffset = header.codesOffset;
+    return true;
+}
+
+// Parses the text file into the cheat list and writes the code words to dbPath as they come.
+// The index only goes in once everything else has been written.
+static void Cheat_CompileDatabase(BufferedFile* text, u64 textSize, u64 textTime, const char* textPath, const char* dbPath)
+{
+    IFile db;
+    CheatDbHeader header = { 0 };
+    u32 stagedCodes = 0;
+    const u32 maxStagedCodes = CHEAT_STAGING_SIZE / sizeof(u64);
+
+    bool dbOpened = Cheat_ReserveMemory(&cheatCodesArena, CHEAT_STAGING_SIZE) && R_SUCCEEDED(IFile_Open(&db, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, dbPath), FS_OPEN_CREATE | FS_OPEN_WRITE));
+    bool writeDb = dbOpened;
+    if (writeDb)
+    {
+        // Invalidate whatever was there until the new header is written
+        writeDb = Cheat_WriteDatabase(&db, &header, sizeof(header));
+    }
 
-    char line[1024] = { 0 };
     Result res = 0;
     CheatDescription* cheat = 0;
-    u32 cheatSize = 0;
     do
     {
-        res = Cheat_ReadLine(&file, line, 1024);
+        u64 lineOffset = BufferedFile_Tell(text);
+        res = Cheat_ReadLine(text, cheatLine, sizeof(cheatLine));
         // -1 is special; it can't be a normal result because of how results are constructed
         // So let's just use it as a signal that this is the final line of a file
         if (R_SUCCEEDED(res) || res == -1)
         {
-            char* strippedLine = stripWhitespace(line);
+            char* strippedLine = stripWhitespace(cheatLine);
             s32 lineLen = strnlen(strippedLine, 1023);
             if (!lineLen)
             {
@@ -1929,49 +2274,291 @@ static void Cheat_LoadCheatsIntoMemory(u64 titleId)
             }
             if (Cheat_IsCodeLine(strippedLine))
             {
-                if (cheatSize + sizeof(u64) >= sizeof(cheatBuffer))
-                {
-                    cheatCount--;
-                    break;
-                }
                 if (cheat)
                 {
                     u64 tmp = Cheat_GetCode(strippedLine);
-                    Cheat_AddCode(cheat, tmp);
-                    cheatSize += sizeof(u64);
+                    if (cheat->codesCount == 0)
+                    {
+                        cheat->codesIndex = lineOffset;
+                    }
+                    cheat->codesCount++;
                     if (((tmp >> 32) & 0xFFFFFFFF) == 0xDD000000)
                     {
                         cheat->hasKeyCode = 1;
                     }
+
+                    if (writeDb)
+                    {
+                        cheatCodes[stagedCodes++] = tmp;
+                        if (stagedCodes == maxStagedCodes)
+                        {
+                            writeDb = Cheat_WriteDatabase(&db, cheatCodes, CHEAT_STAGING_SIZE);
+                            stagedCodes = 0;
+                        }
+                    }
                 }
             }
             else
             {
                 if (!cheat || cheat->codesCount > 0)
                 {
-                    if (cheatSize + sizeof(CheatDescription) >= sizeof(cheatBuffer))
+                    CheatDescription* next = Cheat_AllocCheat();
+                    if (next == NULL)
                     {
+                        // Keep what fits, but don't write a database that would hide the missing cheats
+                        cheatsTruncated = true;
+                        writeDb = false;
                         break;
                     }
-                    cheat = Cheat_AllocCheat();
-                    cheatSize += sizeof(CheatDescription);
+                    cheat = next;
                 }
-                strncpy(cheat->name, line, 38);
+                Cheat_ParseSchedule(cheat, strippedLine);
+                strncpy(cheat->name, cheatLine, 38);
                 cheat->name[38] = '\0';
             }
         }
-    } while (R_SUCCEEDED(res) && cheatSize < sizeof(cheatBuffer));
+    } while (R_SUCCEEDED(res));
 
-    IFile_Close(&file.file);
-
-    if ((cheatCount > 0) && (cheats[cheatCount - 1]->codesCount == 0))
+    if ((cheatCount > 0) && (cheats[cheatCount - 1].codesCount == 0))
     {
         cheatCount--; // Remove last empty cheat
     }
 
+    // Text offsets are kept unless the database was written in full
+    strcpy(cheatDbPath, textPath);
+    cheatDbIsBinary = false;
+
+    if (!writeDb)
+    {
+        if (dbOpened)
+        {
+            IFile_Close(&db);
+        }
+        return;
+    }
+
+    if (stagedCodes > 0)
+    {
+        writeDb = Cheat_WriteDatabase(&db, cheatCodes, stagedCodes * sizeof(u64));
+    }
+
+    header.magic = CHEAT_DB_MAGIC;
+    header.version = CHEAT_DB_VERSION;
+    header.cheatCount = cheatCount;
+    header.sourceSize = textSize;
+    header.sourceTime = textTime;
+    header.codesOffset = sizeof(header);
+    header.indexOffset = db.pos;
+
+    CheatDbEntry* entries = (CheatDbEntry*) cheatCodes;
+    const u32 entriesPerWrite = CHEAT_STAGING_SIZE / sizeof(CheatDbEntry);
+    u32 count = 0;
+    for (s32 i = 0; writeDb && i < cheatCount; i++)
+    {
+        CheatDbEntry* entry = &entries[count++];
+        memset(entry, 0, sizeof(CheatDbEntry));
+        memcpy(entry->name, cheats[i].name, sizeof(entry->name));
+        entry->flags = cheats[i].hasKeyCode ? CHEAT_DB_FLAG_KEYCODE : 0;
+        entry->codesIndex = header.codesCount;
+        entry->codesCount = cheats[i].codesCount;
+        entry->periodFrames = cheats[i].periodFrames;
+        entry->priority = cheats[i].priority;
+        header.codesCount += cheats[i].codesCount;
+
+        if (count == entriesPerWrite || i == cheatCount - 1)
+        {
+            writeDb = Cheat_WriteDatabase(&db, entries, count * sizeof(CheatDbEntry));
+            count = 0;
+        }
+    }
+
+    if (writeDb)
+    {
+        u64 size = db.pos;
+        db.pos = 0;
+        writeDb = Cheat_WriteDatabase(&db, &header, sizeof(header)) && R_SUCCEEDED(IFile_SetSize(&db, size));
+    }
+
+    IFile_Close(&db);
+
+    if (writeDb)
+    {
+        u32 codesIndex = 0;
+        for (s32 i = 0; i < cheatCount; i++)
+        {
+            cheats[i].codesIndex = codesIndex;
+            codesIndex += cheats[i].codesCount;
+        }
+        strcpy(cheatDbPath, dbPath);
+        cheatDbIsBinary = true;
+        cheatDbCodesOffset = header.codesOffset;
+    }
+}
+
+static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+{
+    static const char* const sources[][2] = {
+        { "/luma/titles/%016llX/cheats.txt", "/luma/titles/%016llX/cheats.bin" },
+        { "/cheats/%016llX.txt", "/cheats/%016llX.bin" },
+    };
+
+    Cheat_FreeAllMemory();
+    cheatsTruncated = false;
+    cheatTitleInfo = titleId;
+
+    for (u32 i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+    {
+        char textPath[64] = { 0 };
+        char dbPath[64] = { 0 };
+        sprintf(textPath, sources[i][0], titleId);
+        sprintf(dbPath, sources[i][1], titleId);
+
+        u64 textSize = 0, textTime = 0;
+        bool hasText = R_SUCCEEDED(BufferedFile_Open(&cheatFile, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, textPath), FS_OPEN_READ));
+        if (hasText && R_FAILED(IFile_GetSize(&cheatFile.file, &textSize)))
+        {
+            IFile_Close(&cheatFile.file);
+            hasText = false;
+        }
+
+        if (hasText)
+        {
+            textTime = Cheat_GetFileTime(textPath);
+        }
+
+        // A cheats.bin without its text file is used as is
+        bool found = Cheat_OpenDatabase(dbPath, hasText, textSize, textTime);
+        if (!found && hasText)
+        {
+            Cheat_CompileDatabase(&cheatFile, textSize, textTime, textPath, dbPath);
+            found = true;
+        }
+
+        if (hasText)
+        {
+            IFile_Close(&cheatFile.file);
+        }
+        if (found)
+        {
+            break;
+        }
+    }
+
     memset(cheatPage, 0, 0x1000);
 }
 
+static Result Cheat_ReadTextCodes(CheatDescription* cheat, u64* codes)
+{
+    Result res = BufferedFile_Open(&cheatFile, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, cheatDbPath), FS_OPEN_READ);
+    if (R_FAILED(res))
+    {
+        return res;
+    }
+
+    // Only blank lines and comments can be found between the code lines of a cheat
+    u32 count = 0;
+    BufferedFile_Seek(&cheatFile, cheat->codesIndex);
+    while (count < cheat->codesCount)
+    {
+        res = Cheat_ReadLine(&cheatFile, cheatLine, sizeof(cheatLine));
+        if (R_FAILED(res) && res != -1)
+        {
+            break;
+        }
+
+        char* strippedLine = stripWhitespace(cheatLine);
+        if (Cheat_IsCodeLine(strippedLine))
+        {
+            codes[count++] = Cheat_GetCode(strippedLine);
+        }
+        if (res == -1)
+        {
+            break;
+        }
+    }
+
+    IFile_Close(&cheatFile.file);
+    return count == cheat->codesCount ? 0 : MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_NO_DATA);
+}
+
+static Result Cheat_ReadBinaryCodes(CheatDescription* cheat, u64* codes)
+{
+    IFile db;
+    u64 total;
+    Result res = IFile_Open(&db, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, cheatDbPath), FS_OPEN_READ);
+    if (R_FAILED(res))
+    {
+        return res;
+    }
+
+    db.pos = cheatDbCodesOffset + (u64)cheat->codesIndex * sizeof(u64);
+    res = IFile_Read(&db, &total, codes, cheat->codesCount * sizeof(u64));
+    if (R_SUCCEEDED(res) && total != cheat->codesCount * sizeof(u64))
+    {
+        res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_NO_DATA);
+    }
+
+    IFile_Close(&db);
+    return res;
+}
+
+// Reads the code words of a cheat that is about to be enabled, and compiles them
+static Result Cheat_LoadCodes(CheatDescription* cheat)
+{
+    if (cheat->codes != NULL)
+    {
+        return 0;
+    }
+
+    if (cheat->codesCount > CHEAT_MAX_LOADED_CODES - cheatLoadedCodes ||
+        !Cheat_ReserveMemory(&cheatCodesArena, (cheatLoadedCodes + cheat->codesCount) * sizeof(u64)) ||
+        !Cheat_ReserveMemory(&cheatOpsArena, (cheatLoadedCodes + cheat->codesCount) * sizeof(CheatOp)))
+    {
+        sprintf(failureReason, "Demasiados trucos activados");
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+
+    u64* codes = cheatCodes + cheatLoadedCodes;
+    Result res = cheatDbIsBinary ? Cheat_ReadBinaryCodes(cheat, codes) : Cheat_ReadTextCodes(cheat, codes);
+    if (R_FAILED(res))
+    {
+        sprintf(failureReason, "Lectura de trucos fallo");
+        return res;
+    }
+
+    cheat->codes = codes;
+    Cheat_CompileCheat(cheat, cheatOps + cheatLoadedCodes);
+    cheatLoadedCodes += cheat->codesCount;
+    return res;
+}
+
+static void Cheat_UnloadCodes(CheatDescription* cheat)
+{
+    if (cheat->codes == NULL)
+    {
+        return;
+    }
+
+    u32 start = cheat->codes - cheatCodes;
+    u32 count = cheat->codesCount;
+    u32 tail = cheatLoadedCodes - start - count;
+    memmove(cheatCodes + start, cheatCodes + start + count, tail * sizeof(u64));
+    memmove(cheatOps + start, cheatOps + start + count, tail * sizeof(CheatOp));
+
+    for (s32 i = 0; i < cheatCount; i++)
+    {
+        if (cheats[i].codes != NULL && cheats[i].codes > cheat->codes)
+        {
+            cheats[i].codes -= count;
+            cheats[i].ops -= count;
+        }
+    }
+
+    cheatLoadedCodes -= count;
+    cheat->codes = NULL;
+    cheat->ops = NULL;
+}
+
 static u32 Cheat_GetCurrentProcessAndTitleId(u64* titleId)
 {
     FS_ProgramInfo programInfo;
@@ -1992,9 +2579,20 @@ void Cheat_SeedRng(u64 seed)
     cheatRngState = seed;
 }
 
-void Cheat_ApplyCheats(void)
+static inline bool Cheat_IsDue(const CheatDescription* cheat)
+{
+    return cheat->active && cheat->periodFrames != CHEAT_PERIOD_ONCE && (s32)(cheatFrame - cheat->nextFrame) >= 0;
+}
+
+static void Cheat_RunScheduledCheats(void)
 {
-    if (!cheatCount)
+    bool anyDue = false;
+    for (int i = 0; i < cheatCount && !anyDue; i++)
+    {
+        anyDue = Cheat_IsDue(&cheats[i]);
+    }
+
+    if (!anyDue)
     {
         return;
     }
@@ -2004,23 +2602,90 @@ void Cheat_ApplyCheats(void)
 
     if (!titleId)
     {
-        cheatCount = 0;
+        Cheat_FreeAllMemory();
         return;
     }
 
     if (titleId != cheatTitleInfo)
     {
-        cheatCount = 0;
+        Cheat_FreeAllMemory();
+        return;
+    }
+
+    // Attach once and run every due cheat in the same session
+    Handle debugHandle;
+    if (R_FAILED(Cheat_BeginSession(pid, &debugHandle)))
+    {
         return;
     }
 
-    for (int i = 0; i < cheatCount; i++)
+    u64 startTick = svcGetSystemTick();
+    for (s32 priority = CHEAT_MAX_PRIORITY; priority >= 0; priority--)
+    {
+        for (int i = 0; i < cheatCount; i++)
+        {
+            if (cheats[i].priority != priority || !Cheat_IsDue(&cheats[i]))
+            {
+                continue;
+            }
+            if (svcGetSystemTick() - startTick > CHEAT_BATCH_BUDGET_TICKS)
+            {
+                break;
+            }
+
+            cheats[i].valid = Cheat_ApplyCheat(debugHandle, &cheats[i]);
+            cheats[i].nextFrame = cheatFrame + cheats[i].periodFrames;
+        }
+    }
+
+    Cheat_EndSession(debugHandle);
+
+    cheatLastBatchTicks = svcGetSystemTick() - startTick;
+    if (cheatLastBatchTicks > cheatMaxBatchTicks)
+    {
+        cheatMaxBatchTicks = cheatLastBatchTicks;
+    }
+}
+
+static void Cheat_ThreadMain(void)
+{
+    Handle timer;
+    if (R_FAILED(svcCreateTimer(&timer, RESET_PULSE)))
+    {
+        svcBreak(USERBREAK_PANIC);
+    }
+    svcSetTimer(timer, CHEAT_FRAME_PERIOD_NS, CHEAT_FRAME_PERIOD_NS);
+
+    Handle handles[2] = { preTerminationEvent, timer };
+    while (!preTerminationRequested)
     {
-        if (cheats[i]->active)
+        s32 idx = -1;
+        if (R_FAILED(svcWaitSynchronizationN(&idx, handles, 2, false, -1LL)) || idx == 0)
+        {
+            break;
+        }
+
+        cheatFrame++;
+        if (menuShouldExit || menuIsOpen() || !cheatCount)
         {
-            Cheat_MapMemoryAndApplyCheat(pid, cheats[i]);
-        } 
+            continue;
+        }
+
+        LightLock_Lock(&cheatLock);
+        Cheat_RunScheduledCheats();
+        LightLock_Unlock(&cheatLock);
     }
+
+    svcCancelTimer(timer);
+    svcCloseHandle(timer);
+}
+
+MyThread *cheatCreateThread(void)
+{
+    LightLock_Init(&cheatLock);
+    if(R_FAILED(MyThread_Create(&cheatThread, Cheat_ThreadMain, cheatThreadStack, sizeof(cheatThreadStack), 60, CORE_SYSTEM)))
+        svcBreak(USERBREAK_PANIC);
+    return &cheatThread;
 }
 
 void RosalinaMenu_Cheats(void)
@@ -2032,7 +2697,9 @@ void RosalinaMenu_Cheats(void)
     {
         if (cheatTitleInfo != titleId || cheatCount == 0)
         {
+            LightLock_Lock(&cheatLock);
             Cheat_LoadCheatsIntoMemory(titleId);
+            LightLock_Unlock(&cheatLock);
         }
     }
 
@@ -2074,17 +2741,19 @@ void RosalinaMenu_Cheats(void)
             }
             if (R_SUCCEEDED(r))
             {
-                Draw_DrawFormattedString(10, 10, COLOR_TITLE, "Lista de trucos");
+                Draw_DrawFormattedString(10, 10, COLOR_TITLE, cheatsTruncated ? "Lista de trucos (incompleta)" : "Lista de trucos");
+                Draw_DrawFormattedString(SCREEN_BOT_WIDTH - 10 - SPACING_X * 12, 10, COLOR_WHITE, "%4lu/%4lu us",
+                    (u32)(1000 * 1000 * cheatLastBatchTicks / SYSCLOCK_ARM11), (u32)(1000 * 1000 * cheatMaxBatchTicks / SYSCLOCK_ARM11));
 
                 for (s32 i = 0; i < CHEATS_PER_MENU_PAGE && page * CHEATS_PER_MENU_PAGE + i < cheatCount; i++)
                 {
                     char buf[65] = { 0 };
                     s32 j = page * CHEATS_PER_MENU_PAGE + i;
-                    const char * checkbox = (cheats[j]->active ? "(x) " : "( ) ");
-                    const char * keyAct = (cheats[j]->hasKeyCode ? "*" : " ");
-                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j]->name);
+                    const char * checkbox = (cheats[j].active ? "(x) " : "( ) ");
+                    const char * keyAct = (cheats[j].hasKeyCode ? "*" : " ");
+                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j].name);
 
-                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j]->valid ? COLOR_WHITE : COLOR_RED, buf);
+                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j].valid ? COLOR_WHITE : COLOR_RED, buf);
                     Draw_DrawCharacter(10, 30 + i * SPACING_Y, COLOR_TITLE, j == selected ? '>' : ' ');
                 }
             }
@@ -2109,14 +2778,25 @@ void RosalinaMenu_Cheats(void)
                 break;
             else if ((pressed & KEY_A) && R_SUCCEEDED(r))
             {
-                if (cheats[selected]->active)
+                LightLock_Lock(&cheatLock);
+                if (cheats[selected].active)
                 {
-                    cheats[selected]->active = 0;
+                    cheats[selected].active = 0;
+                    Cheat_UnloadCodes(&cheats[selected]);
                 }
                 else
                 {
-                    r = Cheat_MapMemoryAndApplyCheat(pid, cheats[selected]);
+                    r = Cheat_LoadCodes(&cheats[selected]);
+                    if (R_SUCCEEDED(r))
+                    {
+                        r = Cheat_MapMemoryAndApplyCheat(pid, &cheats[selected]);
+                    }
+                    if (R_FAILED(r))
+                    {
+                        Cheat_UnloadCodes(&cheats[selected]);
+                    }
                 }
+                LightLock_Unlock(&cheatLock);
             }
             else if (pressed & KEY_DOWN)
                 selected++;
@@ -32,7 +32,6 @@
 #include "pmdbgext.h"
 #include "gdb/server.h"
 #include "gdb/debug.h"
-#include "gdb/monitor.h"
 #include "gdb/net.h"
 #include "pmdbgext.h"
 
@@ -47,9 +46,7 @@ Menu debuggerMenu = {
 };
 
 static MyThread debuggerSocketThread;
-static MyThread debuggerDebugThread;
 static u8 ALIGN(8) debuggerSocketThreadStack[0x5000];
-static u8 ALIGN(8) debuggerDebugThreadStack[0x3000];
 
 GDBServer gdbServer = { 0 };
 
@@ -62,13 +59,6 @@ MyThread *debuggerCreateSocketThread(void)
     return &debuggerSocketThread;
 }
 
-void debuggerDebugThreadMain(void);
-MyThread *debuggerCreateDebugThread(void)
-{
-    MyThread_Create(&debuggerDebugThread, debuggerDebugThreadMain, debuggerDebugThreadStack, 0x3000, 0x20, CORE_SYSTEM);
-    return &debuggerDebugThread;
-}
-
 void debuggerFetchAndSetNextApplicationDebugHandleTask(void *argdata)
 {
     (void)argdata;
@@ -93,9 +83,7 @@ Result debuggerDisable(s64 timeout)
         svcSignalEvent(gdbServer.super.shall_terminate_event);
         server_kill_connections(&gdbServer.super);
 
-        res = MyThread_Join(&debuggerDebugThread, timeout);
-        if(res == 0)
-            res = MyThread_Join(&debuggerSocketThread, timeout);
+        res = MyThread_Join(&debuggerSocketThread, timeout);
 
         Handle dummy = 0;
         PMDBG_RunQueuedProcess(&dummy);
@@ -143,7 +131,6 @@ void DebuggerMenu_EnableDebugger(void)
                 if(R_SUCCEEDED(res))
                 {
                     debuggerCreateSocketThread();
-                    debuggerCreateDebugThread();
                     res = svcWaitSynchronizationN(&idx, handles, 3, false, 5 * 1000 * 1000 * 1000LL);
                     if(res == 0) res = gdbServer.super.init_result;
                 }
@@ -240,10 +227,3 @@ void debuggerSocketThreadMain(void)
     GDB_RunServer(&gdbServer);
     GDB_DecrementServerReferenceCount(&gdbServer);
 }
-
-void debuggerDebugThreadMain(void)
-{
-    GDB_IncrementServerReferenceCount(&gdbServer);
-    GDB_RunMonitor(&gdbServer);
-    GDB_DecrementServerReferenceCount(&gdbServer);
-}
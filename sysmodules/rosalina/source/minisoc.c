@@ -762,3 +762,18 @@ ssize_t socSendto(int sockfd, const void *buf, size_t len, int flags, const stru
         return _socuipc_cmda(sockfd, buf, len, flags, dest_addr, addrlen);
     return _socuipc_cmd9(sockfd, buf, len, flags, dest_addr, addrlen);
 }
+
+// Unlike socSend, retries partial sends until the whole buffer has gone out
+ssize_t socSendAll(int sockfd, const void *buf, size_t len, int flags)
+{
+    size_t total = 0;
+    while(total < len)
+    {
+        ssize_t r = socSendto(sockfd, (const u8 *)buf + total, len - total, flags, NULL, 0);
+        if(r <= 0)
+            return -1;
+        total += r;
+    }
+
+    return total;
+}
@@ -185,6 +185,19 @@ void server_run(struct sock_server *serv)
             continue;
         }
 
+        // Clients busy on another thread are left alone until they're done
+        for(nfds_t i = 0; i < serv->nfds; i++)
+        {
+            struct sock_ctx *curr_ctx = serv->ctx_ptrs[i];
+            if(curr_ctx->type == SOCK_CLIENT && !curr_ctx->busy && curr_ctx->should_close)
+                server_close_ctx(serv, curr_ctx);
+            else
+                fds[i].events = curr_ctx->busy ? 0 : POLLIN;
+        }
+
+        if(serv->compact_needed)
+            compact(serv);
+
         for(nfds_t i = 0; i < serv->nfds; i++)
             fds[i].revents = 0;
 
@@ -204,7 +217,9 @@ void server_run(struct sock_server *serv)
         {
             struct sock_ctx *curr_ctx = serv->ctx_ptrs[i];
 
-            if((fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) || curr_ctx->should_close)
+            if(curr_ctx->busy)
+                continue;
+            else if((fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) || curr_ctx->should_close)
                 server_close_ctx(serv, curr_ctx);
 
             else if(fds[i].revents & POLLIN)
@@ -242,6 +257,7 @@ void server_run(struct sock_server *serv)
                             new_ctx->i = new_idx;
                             new_ctx->n = 0;
                             new_ctx->should_close = false;
+                            new_ctx->busy = false;
 
                             serv->ctx_ptrs[new_idx] = new_ctx;
 
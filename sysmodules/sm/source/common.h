@@ -28,6 +28,7 @@ typedef struct SessionData
     u32 replayCmdbuf[4];
     Handle busyClientPortHandle;
     Handle handle;
+    u32 waitHandleIndex;
     bool isSrvPm;
 } SessionData;
 
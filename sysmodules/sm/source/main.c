@@ -20,10 +20,39 @@ SessionDataList sessionDataWaitingForServiceOrPortRegisterList = {NULL, NULL}, s
 SessionDataList sessionDataWaitingPortReadyList = {NULL, NULL};
 
 static SessionData sessionDataPool[76];
-static ProcessData processDataPool[64];
+ProcessData processDataPool[MAX_PROCESSES];
 
 static u8 ALIGN(4) serviceAccessListStaticBuffer[0x110];
 
+#define NB_FIXED_WAIT_HANDLES   3
+#define MAX_WAIT_HANDLES        (NB_FIXED_WAIT_HANDLES + sizeof(sessionDataPool) / sizeof(SessionData))
+
+// Handles passed to svcReplyAndReceive. The first entries are the semaphore and the ports, then each session
+// in sessionDataInUseList (session handle) or sessionDataWaitingPortReadyList (client port handle) has exactly one entry.
+static Handle waitHandles[MAX_WAIT_HANDLES];
+static SessionData *waitHandleSessions[MAX_WAIT_HANDLES];
+static u32 nbWaitHandles = NB_FIXED_WAIT_HANDLES;
+
+static void addWaitHandle(SessionData *sessionData, Handle handle)
+{
+    if(nbWaitHandles >= MAX_WAIT_HANDLES)
+        panic(0);
+
+    sessionData->waitHandleIndex = nbWaitHandles;
+    waitHandles[nbWaitHandles] = handle;
+    waitHandleSessions[nbWaitHandles++] = sessionData;
+}
+
+static void removeWaitHandle(SessionData *sessionData)
+{
+    u32 id = sessionData->waitHandleIndex;
+    SessionData *lastSessionData = waitHandleSessions[--nbWaitHandles];
+
+    waitHandles[id] = waitHandles[nbWaitHandles];
+    waitHandleSessions[id] = lastSessionData;
+    lastSessionData->waitHandleIndex = id;
+}
+
 void __ctru_exit(int rc) { (void)rc; } // needed to avoid linking error
 
 // this is called after main exits
@@ -61,16 +90,14 @@ int main(void)
 {
     Result res;
     u32 *cmdbuf = getThreadCommandBuffer();
-    u32 nbHandles = 3, nbSessions = 0;
     bool srvPmSessionCreated = false;
 
     Handle clientPortDummy;
     Handle srvPort, srvPmPort;
-    Handle handles[0xE3] = { 0 };
     Handle replyTarget = 0;
 
     u32 smPid;
-    SessionData *sessionData;
+    SessionData *sessionData, *replySessionData = NULL;
 
     assertSuccess(svcGetProcessId(&smPid, CUR_PROCESS_HANDLE));
     assertSuccess(svcCreatePort(&srvPort, &clientPortDummy, "srv:", 64));
@@ -80,9 +107,9 @@ int main(void)
     else
         assertSuccess(doRegisterService(smPid, &srvPmPort, "srv:pm", 6, 64));
 
-    handles[0] = resumeGetServiceHandleOrPortRegisteredSemaphore;
-    handles[1] = srvPort;
-    handles[2] = srvPmPort;
+    waitHandles[0] = resumeGetServiceHandleOrPortRegisteredSemaphore;
+    waitHandles[1] = srvPort;
+    waitHandles[2] = srvPmPort;
 
     for(;;)
     {
@@ -90,60 +117,39 @@ int main(void)
         if(replyTarget == 0)
             cmdbuf[0] = 0xFFFF0000; // Kernel11
 
-        // Rebuild the list
-        nbHandles = 3;
-        nbSessions = 0;
-        for(sessionData = sessionDataInUseList.first; sessionData != NULL; sessionData = sessionData->next)
-        {
-            handles[nbHandles++] = sessionData->handle;
-            nbSessions++;
-        }
-
-        for(sessionData = sessionDataWaitingPortReadyList.first; sessionData != NULL; sessionData = sessionData->next)
-        {
-            handles[nbHandles++] = sessionData->busyClientPortHandle;
-        }
-
-        res = svcReplyAndReceive(&id, handles, nbHandles, replyTarget);
+        res = svcReplyAndReceive(&id, waitHandles, nbWaitHandles, replyTarget);
         if(res == (Result)0xC920181A) // unreachable remote
         {
             // Note: if a process has ended, pm will call UnregisterProcess on it
             if(id < 0)
             {
-                for(id = 0; (u32)id < nbHandles && handles[id] != replyTarget; id++);
-                if((u32)id >= nbHandles)
+                if(replySessionData == NULL)
                     panic(res);
+                id = replySessionData->waitHandleIndex;
             }
 
-            if(id < 3)
+            if(id < NB_FIXED_WAIT_HANDLES)
                 panic(0);
-            else if((u32)id < 3 + nbSessions) // Session closed
-            {
-                sessionData = NULL;
-                for(u32 i = 0; i < sizeof(sessionDataPool) / sizeof(SessionData); i++)
-                {
-                    if(sessionDataPool[i].handle == handles[id])
-                        sessionData = &sessionDataPool[i];
-                }
 
-                if(sessionData != NULL)
-                {
-                    svcCloseHandle(sessionData->handle);
-                    moveNode(sessionData, &freeSessionDataList, false);
-                }
-                else
-                    panic(0);
+            sessionData = waitHandleSessions[id];
+            if(sessionData->parent == &sessionDataInUseList) // Session closed
+            {
+                removeWaitHandle(sessionData);
+                svcCloseHandle(sessionData->handle);
+                moveNode(sessionData, &freeSessionDataList, false);
             }
             else // Port closed
             {
+                Handle port = waitHandles[id];
                 SessionData *nextSessionData = NULL;
 
                 // Update the command postponing reason accordingly
                 for(sessionData = sessionDataWaitingPortReadyList.first; sessionData != NULL; sessionData = nextSessionData)
                 {
                     nextSessionData = sessionData->next;
-                    if(sessionData->busyClientPortHandle == handles[id])
+                    if(sessionData->busyClientPortHandle == port)
                     {
+                        removeWaitHandle(sessionData);
                         sessionData->replayCmdbuf[1] = 0xD0406401; // unregistered service or named port
                         moveNode(sessionData, &sessionDataWaitingForServiceOrPortRegisterList, true);
                         sessionData->busyClientPortHandle = 0;
@@ -154,12 +160,14 @@ int main(void)
             }
 
             replyTarget = 0;
+            replySessionData = NULL;
         }
         else if(R_FAILED(res))
             panic(res);
         else
         {
             replyTarget = 0;
+            replySessionData = NULL;
             if(id == 1) // New srv: session
             {
                 Handle session;
@@ -167,6 +175,7 @@ int main(void)
                 sessionData = (SessionData *)allocateNode(&sessionDataInUseList, &freeSessionDataList, sizeof(SessionData), false);
                 sessionData->pid = (u32)-1;
                 sessionData->handle = session;
+                addWaitHandle(sessionData, session);
             }
             else if(id == 2) // New srv:pm session
             {
@@ -178,6 +187,7 @@ int main(void)
                 sessionData->pid = (u32)-1;
                 sessionData->handle = session;
                 sessionData->isSrvPm = true;
+                addWaitHandle(sessionData, session);
             }
             else
             {
@@ -187,43 +197,43 @@ int main(void)
                         panic(0);
                     sessionData = sessionDataToWakeUpAfterServiceOrPortRegisterList.first;
                     moveNode(sessionData, &sessionDataInUseList, false);
+                    addWaitHandle(sessionData, sessionData->handle);
                     memcpy(cmdbuf, sessionData->replayCmdbuf, 16);
                 }
-                else if((u32)id >= 3 + nbSessions) // Resume SRV:GetServiceHandle if service was full
-                {
-                    for(sessionData = sessionDataWaitingPortReadyList.first; sessionData != NULL && sessionData->busyClientPortHandle != handles[id];
-                        sessionData = sessionData->next);
-                    if(sessionData == NULL) {
-                        // Ignore (client process could have ended) and continue
-                        continue;
-                    }
-                    moveNode(sessionData, &sessionDataInUseList, false);
-                    memcpy(cmdbuf, sessionData->replayCmdbuf, 16);
-                    sessionData->busyClientPortHandle = 0;
-                }
                 else
                 {
-                    for(sessionData = sessionDataInUseList.first; sessionData != NULL && sessionData->handle != handles[id]; sessionData = sessionData->next);
-                    if(sessionData == NULL)
-                        panic(0);
+                    sessionData = waitHandleSessions[id];
+                    if(sessionData->parent == &sessionDataWaitingPortReadyList) // Resume SRV:GetServiceHandle if service was full
+                    {
+                        moveNode(sessionData, &sessionDataInUseList, false);
+                        waitHandles[id] = sessionData->handle;
+                        memcpy(cmdbuf, sessionData->replayCmdbuf, 16);
+                        sessionData->busyClientPortHandle = 0;
+                    }
                 }
 
                 res = sessionData->isSrvPm ? srvPmHandleCommands(sessionData) : srvHandleCommands(sessionData);
 
                 if(R_MODULE(res) == RM_SRV && R_SUMMARY(res) == RS_WOULDBLOCK)
                 {
-                    SessionDataList *dstList = NULL;
                     if(res == (Result)0xD0406401) // service or named port not registered yet
-                        dstList = &sessionDataWaitingForServiceOrPortRegisterList;
+                    {
+                        removeWaitHandle(sessionData);
+                        moveNode(sessionData, &sessionDataWaitingForServiceOrPortRegisterList, true);
+                    }
                     else if(res == (Result)0xD0406402) // service full
-                        dstList = &sessionDataWaitingPortReadyList;
+                    {
+                        waitHandles[sessionData->waitHandleIndex] = sessionData->busyClientPortHandle;
+                        moveNode(sessionData, &sessionDataWaitingPortReadyList, true);
+                    }
                     else
                         panic(res);
-
-                    moveNode(sessionData, dstList, true);
                 }
                 else
+                {
                     replyTarget = sessionData->handle;
+                    replySessionData = sessionData;
+                }
             }
         }
     }
@@ -10,6 +10,97 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 
 #include <stdatomic.h>
 
+// Open addressing (linear probing) index from notification IDs to their subscribers, as bitsets of processDataPool
+// slots. An empty subscriber set marks an empty entry; the table is kept at most half full.
+#define NOTIFICATION_TABLE_BITS         10
+#define NOTIFICATION_TABLE_MASK         ((1u << NOTIFICATION_TABLE_BITS) - 1)
+#define MAX_SUBSCRIBED_NOTIFICATIONS    (1u << (NOTIFICATION_TABLE_BITS - 1))
+_Static_assert(MAX_PROCESSES <= 64, "Subscriber sets can't hold more than 64 processes");
+
+static u32 notificationIds[1u << NOTIFICATION_TABLE_BITS] = { 0 };
+static u64 notificationSubscribers[1u << NOTIFICATION_TABLE_BITS] = { 0 };
+static u32 nbSubscribedNotifications = 0;
+
+static inline u32 hashNotificationId(u32 notificationId)
+{
+    return (notificationId * 0x9E3779B1) >> (32 - NOTIFICATION_TABLE_BITS);
+}
+
+static inline u64 getProcessMask(const ProcessData *processData)
+{
+    return 1ull << (processData - processDataPool);
+}
+
+static s32 findNotificationSlot(u32 notificationId)
+{
+    for(u32 slot = hashNotificationId(notificationId); notificationSubscribers[slot] != 0; slot = (slot + 1) & NOTIFICATION_TABLE_MASK)
+    {
+        if(notificationIds[slot] == notificationId)
+            return slot;
+    }
+
+    return -1;
+}
+
+static u64 getSubscribers(u32 notificationId)
+{
+    s32 slot = findNotificationSlot(notificationId);
+    return slot == -1 ? 0 : notificationSubscribers[slot];
+}
+
+static bool addSubscriber(u32 notificationId, const ProcessData *processData)
+{
+    u32 slot;
+    for(slot = hashNotificationId(notificationId); notificationSubscribers[slot] != 0 && notificationIds[slot] != notificationId;
+        slot = (slot + 1) & NOTIFICATION_TABLE_MASK);
+
+    if(notificationSubscribers[slot] == 0)
+    {
+        if(nbSubscribedNotifications >= MAX_SUBSCRIBED_NOTIFICATIONS)
+            return false;
+        ++nbSubscribedNotifications;
+        notificationIds[slot] = notificationId;
+    }
+
+    notificationSubscribers[slot] |= getProcessMask(processData);
+    return true;
+}
+
+static void removeSubscriber(u32 notificationId, const ProcessData *processData)
+{
+    s32 slot = findNotificationSlot(notificationId);
+    if(slot == -1)
+        return;
+
+    notificationSubscribers[slot] &= ~getProcessMask(processData);
+    if(notificationSubscribers[slot] != 0)
+        return;
+
+    --nbSubscribedNotifications;
+
+    // Backward shift deletion, see services.c
+    u32 hole = slot;
+    for(u32 i = (slot + 1) & NOTIFICATION_TABLE_MASK; notificationSubscribers[i] != 0; i = (i + 1) & NOTIFICATION_TABLE_MASK)
+    {
+        u32 home = hashNotificationId(notificationIds[i]);
+        if(((i - home) & NOTIFICATION_TABLE_MASK) >= ((i - hole) & NOTIFICATION_TABLE_MASK))
+        {
+            notificationIds[hole] = notificationIds[i];
+            notificationSubscribers[hole] = notificationSubscribers[i];
+            hole = i;
+        }
+    }
+
+    notificationSubscribers[hole] = 0;
+}
+
+void removeProcessSubscriptions(ProcessData *processData)
+{
+    for(u16 i = 0; i < processData->nbSubscribed; i++)
+        removeSubscriber(processData->subscribedNotifications[i], processData);
+    processData->nbSubscribed = 0;
+}
+
 static bool isNotificationInhibited(const ProcessData *processData, u32 notificationId)
 {
     (void)processData;
@@ -72,14 +163,9 @@ Result Subscribe(SessionData *sessionData, u32 notificationId)
 
     if(processData == NULL || !processData->notificationEnabled)
         return 0xD8806404;
-
-    for(u16 i = 0; i < processData->nbSubscribed; i++)
-    {
-        if(processData->subscribedNotifications[i] == notificationId)
-            return 0xD9006403;
-    }
-
-    if(processData->nbSubscribed < 0x11)
+    else if(getSubscribers(notificationId) & getProcessMask(processData))
+        return 0xD9006403;
+    else if(processData->nbSubscribed < MAX_PROCESS_SUBSCRIPTIONS && addSubscriber(notificationId, processData))
     {
         processData->subscribedNotifications[processData->nbSubscribed++] = notificationId;
         return 0;
@@ -102,6 +188,7 @@ Result Unsubscribe(SessionData *sessionData, u32 notificationId)
         return 0xD8806404;
     else
     {
+        removeSubscriber(notificationId, processData);
         processData->subscribedNotifications[i] = processData->subscribedNotifications[--processData->nbSubscribed];
         return 0;
     }
@@ -128,14 +215,16 @@ Result ReceiveNotification(SessionData *sessionData, u32 *notificationId)
 
 Result PublishToSubscriber(u32 notificationId, u32 flags)
 {
-    for(ProcessData *node = processDataInUseList.first; node != NULL; node = node->next)
+    // Subscribers are still notified in processDataInUseList order, which shows in which of them get the
+    // notification when one fails, and in the order of the PIDs returned by PublishAndGetSubscriber
+    u64 subscribers = getSubscribers(notificationId);
+    for(ProcessData *node = processDataInUseList.first; node != NULL && subscribers != 0; node = node->next)
     {
-        if(!node->notificationEnabled || isNotificationInhibited(node, notificationId))
+        if(!(subscribers & getProcessMask(node)))
             continue;
 
-        u16 i;
-        for(i = 0; i < node->nbSubscribed && node->subscribedNotifications[i] != notificationId; i++);
-        if(i >= node->nbSubscribed)
+        subscribers &= ~getProcessMask(node);
+        if(!node->notificationEnabled || isNotificationInhibited(node, notificationId))
             continue;
 
         if(!doPublishNotification(node, notificationId, flags))
@@ -148,14 +237,14 @@ Result PublishToSubscriber(u32 notificationId, u32 flags)
 Result PublishAndGetSubscriber(u32 *pidCount, u32 *pidList, u32 notificationId, u32 flags)
 {
     u32 nb = 0;
-    for(ProcessData *node = processDataInUseList.first; node != NULL; node = node->next)
+    u64 subscribers = getSubscribers(notificationId);
+    for(ProcessData *node = processDataInUseList.first; node != NULL && subscribers != 0; node = node->next)
     {
-        if(!node->notificationEnabled || isNotificationInhibited(node, notificationId))
+        if(!(subscribers & getProcessMask(node)))
             continue;
 
-        u16 i;
-        for(i = 0; i < node->nbSubscribed && node->subscribedNotifications[i] != notificationId; i++);
-        if(i >= node->nbSubscribed)
+        subscribers &= ~getProcessMask(node);
+        if(!node->notificationEnabled || isNotificationInhibited(node, notificationId))
             continue;
 
         if(!doPublishNotification(node, notificationId, flags))
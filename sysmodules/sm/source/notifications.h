@@ -8,6 +8,9 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #pragma once
 
 #include "common.h"
+#include "processes.h"
+
+void removeProcessSubscriptions(ProcessData *processData);
 
 Result EnableNotification(SessionData *sessionData, Handle *notificationSemaphore);
 Result Subscribe(SessionData *sessionData, u32 notificationId);
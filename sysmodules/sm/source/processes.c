@@ -8,6 +8,7 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #include "list.h"
 #include "processes.h"
 #include "services.h"
+#include "notifications.h"
 
 ProcessDataList processDataInUseList = { NULL, NULL }, freeProcessDataList = { NULL, NULL };
 
@@ -56,6 +57,7 @@ Result UnregisterProcess(u32 pid)
         return 0xD8806404;
 
     svcCloseHandle(processData->notificationSemaphore);
+    removeProcessSubscriptions(processData);
 
     // Unregister the services registered by the process
     u32 i = 0;
@@ -64,7 +66,7 @@ Result UnregisterProcess(u32 pid)
         if(servicesInfo[i].pid == pid)
         {
             svcCloseHandle(servicesInfo[i].clientPort);
-            servicesInfo[i] = servicesInfo[--nbServices];
+            removeServiceInfo(i);
         }
         else
             ++i;
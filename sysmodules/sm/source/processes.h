@@ -9,6 +9,13 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 
 #include "common.h"
 
+// Can be overridden at build time; notification subscriber sets are 64-bit masks of processDataPool slots
+#ifndef MAX_PROCESSES
+#define MAX_PROCESSES           64
+#endif
+
+#define MAX_PROCESS_SUBSCRIPTIONS   0x11
+
 struct ProcessDataList;
 
 typedef struct ProcessData
@@ -31,7 +38,7 @@ typedef struct ProcessData
     u16 nbPendingNotifications;
     u32 pendingNotifications[16];
     u16 nbSubscribed;
-    u32 subscribedNotifications[17];
+    u32 subscribedNotifications[MAX_PROCESS_SUBSCRIPTIONS];
 } ProcessData;
 
 typedef struct ProcessDataList
@@ -40,6 +47,7 @@ typedef struct ProcessDataList
 } ProcessDataList;
 
 extern ProcessDataList processDataInUseList, freeProcessDataList;
+extern ProcessData processDataPool[MAX_PROCESSES];
 
 ProcessData *findProcessData(u32 pid);
 ProcessData *doRegisterProcess(u32 pid, char (*serviceAccessList)[8], u32 serviceAccessListSize);
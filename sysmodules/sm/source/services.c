@@ -10,9 +10,14 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #include "processes.h"
 #include "list.h"
 
-ServiceInfo servicesInfo[0xA0] = { 0 };
+ServiceInfo servicesInfo[MAX_SERVICES] = { 0 };
 u32 nbServices = 0; // including "ports" registered with getPort
 
+// Open addressing (linear probing) index of servicesInfo, entries are serviceId + 1, 0 being empty
+#define SERVICE_TABLE_MASK ((1u << SERVICE_TABLE_BITS) - 1)
+_Static_assert((1u << SERVICE_TABLE_BITS) >= 2 * MAX_SERVICES, "Service table too small");
+static u16 serviceTable[1u << SERVICE_TABLE_BITS] = { 0 };
+
 static Result checkServiceName(const char *name, s32 nameSize)
 {
     if(nameSize <= 0 || nameSize > 8)
@@ -23,17 +28,74 @@ static Result checkServiceName(const char *name, s32 nameSize)
         return 0;
 }
 
-static inline bool areServiceNamesEqual(const char *name, const char *name2, s32 nameSize)
+static inline u64 makeServiceKey(const char *name, s32 nameSize)
+{
+    // Names have been checked, and can't contain NUL characters
+    u64 key = 0;
+    memcpy(&key, name, nameSize > 8 ? 8 : nameSize);
+    return key;
+}
+
+static inline u32 hashServiceKey(u64 key, bool isNamedPort)
 {
-    return strncmp(name, name2, nameSize) == 0 && (nameSize == 8 || name[nameSize] == 0);
+    u32 x = (u32)key ^ ((u32)(key >> 32) * 0x85EBCA77) ^ isNamedPort;
+    return (x * 0x9E3779B1) >> (32 - SERVICE_TABLE_BITS);
+}
+
+static s32 findServiceSlot(u64 key, bool isNamedPort)
+{
+    for(u32 slot = hashServiceKey(key, isNamedPort); serviceTable[slot] != 0; slot = (slot + 1) & SERVICE_TABLE_MASK)
+    {
+        ServiceInfo *info = &servicesInfo[serviceTable[slot] - 1];
+        if(info->nameKey == key && info->isNamedPort == isNamedPort)
+            return slot;
+    }
+
+    return -1;
 }
 
 static s32 findServicePortByName(bool isNamedPort, const char *name, s32 nameSize)
 {
-    ServiceInfo *info;
-    for(info = servicesInfo; info < servicesInfo + nbServices && (info->isNamedPort != isNamedPort || !areServiceNamesEqual(info->name, name, nameSize)); info++);
+    s32 slot = findServiceSlot(makeServiceKey(name, nameSize), isNamedPort);
+    return slot == -1 ? -1 : serviceTable[slot] - 1;
+}
+
+static void addServiceSlot(u32 serviceId)
+{
+    u32 slot;
+    for(slot = hashServiceKey(servicesInfo[serviceId].nameKey, servicesInfo[serviceId].isNamedPort); serviceTable[slot] != 0; slot = (slot + 1) & SERVICE_TABLE_MASK);
+    serviceTable[slot] = serviceId + 1;
+}
+
+static void removeServiceSlot(u32 slot)
+{
+    // Backward shift deletion: move back the following entries that can't be found anymore past the hole
+    u32 hole = slot;
+    for(u32 i = (slot + 1) & SERVICE_TABLE_MASK; serviceTable[i] != 0; i = (i + 1) & SERVICE_TABLE_MASK)
+    {
+        ServiceInfo *info = &servicesInfo[serviceTable[i] - 1];
+        u32 home = hashServiceKey(info->nameKey, info->isNamedPort);
+        if(((i - home) & SERVICE_TABLE_MASK) >= ((i - hole) & SERVICE_TABLE_MASK))
+        {
+            serviceTable[hole] = serviceTable[i];
+            hole = i;
+        }
+    }
 
-    return info >= servicesInfo + nbServices ? -1 : info - servicesInfo;
+    serviceTable[hole] = 0;
+}
+
+void removeServiceInfo(u32 serviceId)
+{
+    ServiceInfo *info = &servicesInfo[serviceId];
+    removeServiceSlot(findServiceSlot(info->nameKey, info->isNamedPort));
+
+    // The last entry takes its place
+    if(serviceId != --nbServices)
+    {
+        *info = servicesInfo[nbServices];
+        serviceTable[findServiceSlot(info->nameKey, info->isNamedPort)] = serviceId + 1;
+    }
 }
 
 static bool checkServiceAccess(SessionData *sessionData, const char *name, s32 nameSize)
@@ -55,7 +117,7 @@ static Result doRegisterServiceOrPort(u32 pid, Handle *serverPort, Handle client
     else if(findServicePortByName(isNamedPort, name, nameSize) != -1)
         return 0xD9001BFC;
 
-    if(nbServices >= 0xA0)
+    if(nbServices >= MAX_SERVICES)
         return 0xD86067F3;
 
     if(!isNamedPort)
@@ -70,12 +132,14 @@ static Result doRegisterServiceOrPort(u32 pid, Handle *serverPort, Handle client
     else
         portClient = clientPort;
 
-    ServiceInfo *serviceInfo = &servicesInfo[nbServices++];
-    strncpy(serviceInfo->name, name, 8);
+    u64 key = makeServiceKey(name, nameSize);
+    ServiceInfo *serviceInfo = &servicesInfo[nbServices];
+    serviceInfo->nameKey = key;
 
     serviceInfo->pid = pid;
     serviceInfo->clientPort = portClient;
     serviceInfo->isNamedPort = isNamedPort;
+    addServiceSlot(nbServices++);
 
     SessionData *nextSessionData;
     s32 n = 0;
@@ -84,7 +148,7 @@ static Result doRegisterServiceOrPort(u32 pid, Handle *serverPort, Handle client
     {
         nextSessionData = node->next;
         if((node->replayCmdbuf[0] & 0xF0000) == (!isNamedPort ? 0x50000 : 0x80000) &&
-            areServiceNamesEqual((const char *)(node->replayCmdbuf + 1), name, (s32)node->replayCmdbuf[3]))
+            makeServiceKey((const char *)(node->replayCmdbuf + 1), (s32)node->replayCmdbuf[3]) == key)
         {
             moveNode(node, &sessionDataToWakeUpAfterServiceOrPortRegisterList, true);
             ++n;
@@ -134,7 +198,7 @@ static Result UnregisterServiceOrPort(SessionData *sessionData, const char *name
     {
         svcCloseHandle(servicesInfo[serviceId].clientPort);
 
-        servicesInfo[serviceId] = servicesInfo[--nbServices];
+        removeServiceInfo(serviceId);
         return 0;
     }
 }
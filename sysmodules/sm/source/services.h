@@ -11,17 +11,31 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 
 #include "common.h"
 
+// Both can be overridden at build time; the lookup table has to be at most half full
+#ifndef MAX_SERVICES
+#define MAX_SERVICES            0xA0
+#endif
+#ifndef SERVICE_TABLE_BITS
+#define SERVICE_TABLE_BITS      9
+#endif
+
 typedef struct ServiceInfo
 {
-    char name[8];
+    union
+    {
+        char name[8];
+        u64 nameKey; // name, zero-padded
+    };
     Handle clientPort;
     u32 pid;
     bool isNamedPort;
 } ServiceInfo;
 
-extern ServiceInfo servicesInfo[0xA0];
+extern ServiceInfo servicesInfo[MAX_SERVICES];
 extern u32 nbServices;
 
+void removeServiceInfo(u32 serviceId);
+
 Result doRegisterService(u32 pid, Handle *serverPort, const char *name, s32 nameSize, s32 maxSessions);
 Result RegisterService(SessionData *sessionData, Handle *serverPort, const char *name, s32 nameSize, s32 maxSessions);
 Result RegisterPort(SessionData *sessionData, Handle clientPort, const char *name, s32 nameSize);
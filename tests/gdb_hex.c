@@ -0,0 +1,258 @@
+// Rosalina's GDB packet encoding helpers (sysmodules/rosalina/source/gdb/hex.c), checked against the
+// straightforward implementations they replaced
+
+#include "test.h"
+#include "gdb/hex.h"
+
+static u8 Ref_ComputeChecksum(const char *packetData, u32 len)
+{
+    u8 cksum = 0;
+    for(u32 i = 0; i < len; i++)
+        cksum += (u8)packetData[i];
+
+    return cksum;
+}
+
+static void Ref_EncodeHex(char *dst, const void *src, u32 len)
+{
+    static const char *alphabet = "0123456789abcdef";
+    const u8 *src8 = (u8 *)src;
+
+    for(u32 i = 0; i < len; i++)
+    {
+        dst[2 * i] = alphabet[(src8[i] & 0xf0) >> 4];
+        dst[2 * i + 1] = alphabet[src8[i] & 0x0f];
+    }
+}
+
+static inline u32 Ref_DecodeHexDigit(char src, bool *ok)
+{
+    *ok = true;
+    if(src >= '0' && src <= '9') return src - '0';
+    else if(src >= 'a' && src <= 'f') return 0xA + (src - 'a');
+    else if(src >= 'A' && src <= 'F') return 0xA + (src - 'A');
+    else
+    {
+        *ok = false;
+        return 0;
+    }
+}
+
+// Also writes a garbage byte for the pair it stops at, which callers never looked at. The old version had a single
+// ok flag that the low digit overwrote, letting pairs like "g0" through; the new one rejects those, and so does this
+static u32 Ref_DecodeHex(void *dst, const char *src, u32 len)
+{
+    u32 i = 0;
+    bool ok = true, okLow = true;
+    u8 *dst8 = (u8 *)dst;
+    for(i = 0; i < len && ok && src[2 * i] != 0 && src[2 * i + 1] != 0; i++)
+    {
+        dst8[i] = (Ref_DecodeHexDigit(src[2 * i], &ok) << 4) | Ref_DecodeHexDigit(src[2 * i + 1], &okLow);
+        ok = ok && okLow;
+    }
+
+    return (!ok) ? i - 1 : i;
+}
+
+static u32 Ref_UnescapeBinaryData(void *dst, const void *src, u32 len)
+{
+    u8 *dst8 = (u8 *)dst;
+    const u8 *src8 = (const u8 *)src;
+
+    while((uintptr_t)src8 < (uintptr_t)src + len)
+    {
+        if(*src8 == '}')
+        {
+            src8++;
+            *dst8++ = *src8++ ^ 0x20;
+        }
+        else
+            *dst8++ = *src8++;
+    }
+
+    return dst8 - (u8 *)dst;
+}
+
+static bool isEscaped(u8 c)
+{
+    return c == '$' || c == '#' || c == '}' || c == '*';
+}
+
+#define BUF_LEN 0x4000
+
+static u8 data[BUF_LEN + 8];
+static char out[2 * BUF_LEN + 8], refOut[2 * BUF_LEN + 8];
+
+static void testChecksum(void)
+{
+    testFillRandom(data, sizeof(data));
+
+    // Every length at every alignment, to go through the head, word and tail loops
+    for(u32 offset = 0; offset < 8; offset++)
+    {
+        for(u32 len = 0; len <= 0x1000; len++)
+        {
+            u8 cksum = GDB_ComputeChecksum((const char *)data + offset, len);
+            u8 ref = Ref_ComputeChecksum((const char *)data + offset, len);
+            CHECK(cksum == ref, "checksum of %u bytes at +%u: %02x, expected %02x", len, offset, cksum, ref);
+        }
+    }
+
+    // 0xFF everywhere is the worst case for the 16-bit lanes, over a whole packet
+    memset(data, 0xFF, sizeof(data));
+    for(u32 len = BUF_LEN - 0x40; len <= BUF_LEN; len++)
+    {
+        u8 cksum = GDB_ComputeChecksum((const char *)data, len);
+        u8 ref = Ref_ComputeChecksum((const char *)data, len);
+        CHECK(cksum == ref, "checksum of %u 0xFF bytes: %02x, expected %02x", len, cksum, ref);
+    }
+}
+
+static void testEncodeHex(void)
+{
+    for(u32 i = 0; i < 256; i++)
+        data[i] = (u8)i;
+
+    GDB_EncodeHex(out, data, 256);
+    Ref_EncodeHex(refOut, data, 256);
+    CHECK(memcmp(out, refOut, 512) == 0, "encoding of every byte value differs");
+
+    testFillRandom(data, BUF_LEN);
+    memset(out, 0x55, sizeof(out));
+    GDB_EncodeHex(out, data, BUF_LEN - 1);
+    Ref_EncodeHex(refOut, data, BUF_LEN - 1);
+    CHECK(memcmp(out, refOut, 2 * (BUF_LEN - 1)) == 0, "encoding of random data differs");
+    CHECK(out[2 * (BUF_LEN - 1)] == 0x55, "encoding wrote past its output");
+}
+
+static void testDecodeHex(void)
+{
+    // Every pair of characters, NUL included
+    for(u32 hi = 0; hi < 256; hi++)
+    {
+        for(u32 lo = 0; lo < 256; lo++)
+        {
+            char src[3] = { (char)hi, (char)lo, 0 };
+            u8 b = 0, refB = 0;
+            u32 n = GDB_DecodeHex(&b, src, 1);
+            u32 ref = Ref_DecodeHex(&refB, src, 1);
+
+            CHECK(n == ref, "decoding %02x %02x: %u pairs, expected %u", hi, lo, n, ref);
+            CHECK(n == 0 || b == refB, "decoding %02x %02x: %02x, expected %02x", hi, lo, b, refB);
+        }
+    }
+
+    // Longer strings, mostly made of hex digits, that stop at a random pair
+    static const char alphabet[] = "0123456789abcdefABCDEF0123456789abcdefABCDEFgG:/ \x80";
+    for(u32 iter = 0; iter < 100000; iter++)
+    {
+        u32 len = testRandom() % 64;
+        char src[2 * 64 + 2];
+        for(u32 i = 0; i < 2 * len; i++)
+            src[i] = alphabet[testRandom() % (sizeof(alphabet) - 1)];
+        src[2 * len] = 0;
+        src[2 * len + 1] = 0;
+
+        u8 dst[64], refDst[64];
+        u32 askedLen = testRandom() % (len + 2);
+        u32 n = GDB_DecodeHex(dst, src, askedLen);
+        u32 ref = Ref_DecodeHex(refDst, src, askedLen);
+
+        CHECK(n == ref, "decoding \"%s\": %u pairs, expected %u", src, n, ref);
+        CHECK(n != ref || memcmp(dst, refDst, n) == 0, "decoding \"%s\" gives different bytes", src);
+    }
+}
+
+static void testEscape(void)
+{
+    for(u32 iter = 0; iter < 100000; iter++)
+    {
+        // Plenty of characters that need escaping
+        u32 len = testRandom() % 256;
+        for(u32 i = 0; i < len; i++)
+            data[i] = (testRandom() & 1) ? "$#}*"[testRandom() % 4] : (u8)testRandom();
+
+        u32 maxLen = testRandom() % (2 * len + 2);
+        u32 encodedCount = 0;
+        memset(out, 0x55, sizeof(out));
+        u32 consumed = GDB_EscapeBinaryData(&encodedCount, out, data, len, maxLen);
+
+        // The longest prefix of the input whose escaped form fits in maxLen
+        u32 refConsumed = 0, refCount = 0;
+        while(refConsumed < len && refCount + (isEscaped(data[refConsumed]) ? 2 : 1) <= maxLen)
+            refCount += isEscaped(data[refConsumed++]) ? 2 : 1;
+
+        CHECK(consumed == refConsumed && encodedCount == refCount, "escaping %u bytes into %u: %u -> %u, expected %u -> %u",
+            len, maxLen, consumed, encodedCount, refConsumed, refCount);
+        CHECK(encodedCount >= sizeof(out) || (u8)out[encodedCount] == 0x55, "escaping wrote past what it reported");
+
+        u8 back[512];
+        u32 n = GDB_UnescapeBinaryData(back, out, encodedCount);
+        CHECK(n == consumed && memcmp(back, data, n) == 0, "unescaping what was escaped doesn't give the input back");
+
+        u8 refBack[512];
+        u32 ref = Ref_UnescapeBinaryData(refBack, out, encodedCount);
+        CHECK(n == ref && memcmp(back, refBack, n) == 0, "unescaping differs");
+    }
+
+    // In place, as the packet handlers do it
+    for(u32 iter = 0; iter < 10000; iter++)
+    {
+        u32 len = testRandom() % 256;
+        for(u32 i = 0; i < len; i++)
+            data[i] = (testRandom() & 1) ? "$#}*"[testRandom() % 4] : (u8)testRandom();
+
+        u32 encodedCount;
+        GDB_EscapeBinaryData(&encodedCount, out, data, len, sizeof(out));
+        u32 n = GDB_UnescapeBinaryData(out, out, encodedCount);
+        CHECK(n == len && memcmp(out, data, len) == 0, "unescaping in place doesn't give the input back");
+    }
+}
+
+#define BENCH(label, iterations, ...)\
+do\
+{\
+    double start = testNow();\
+    for(u32 iter = 0; iter < (iterations); iter++)\
+    {\
+        __VA_ARGS__;\
+        __asm__ __volatile__("" ::: "memory");\
+    }\
+    double elapsed = testNow() - start;\
+    printf("  %-24s %8.1f MB/s\n", label, (iterations) * (double)BUF_LEN / elapsed / 1e6);\
+}\
+while(0)
+
+static void bench(void)
+{
+    volatile u8 sink = 0;
+    const u32 iterations = 20000;
+
+    printf("gdb_hex: host timings over %u KiB buffers, the console's are what matter\n", BUF_LEN / 1024);
+
+    testFillRandom(data, BUF_LEN);
+    BENCH("checksum (old)", iterations, sink += Ref_ComputeChecksum((const char *)data, BUF_LEN));
+    BENCH("checksum", iterations, sink += GDB_ComputeChecksum((const char *)data, BUF_LEN));
+    BENCH("encode (old)", iterations, Ref_EncodeHex(out, data, BUF_LEN));
+    BENCH("encode", iterations, GDB_EncodeHex(out, data, BUF_LEN));
+
+    GDB_EncodeHex(out, data, BUF_LEN);
+    out[2 * BUF_LEN] = 0;
+    BENCH("decode (old)", iterations, sink += Ref_DecodeHex(data, out, BUF_LEN));
+    BENCH("decode", iterations, sink += GDB_DecodeHex(data, out, BUF_LEN));
+
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    testChecksum();
+    testEncodeHex();
+    testDecodeHex();
+    testEscape();
+
+    if(testWantsBench(argc, argv))
+        bench();
+
+    return testReport("gdb_hex");
+}
@@ -0,0 +1,210 @@
+// The cheat finder's value scanner (sysmodules/rosalina/source/memscan.c), checked against a naive
+// value-by-value filter
+
+#include "test.h"
+#include "memscan.h"
+
+static const char *typeNames[MEMSCAN_TYPE_COUNT] = { "u8", "u16", "u32", "float" };
+static const char *compareNames[MEMSCAN_CMP_COUNT] = { "unknown", "equal", "changed", "unchanged", "increased", "decreased" };
+
+static u32 refLoad(const u8 *p, MemScanType type)
+{
+    u32 v = 0;
+    memcpy(&v, p, MemScan_TypeSize(type));
+    return v;
+}
+
+static bool refMatches(MemScanType type, MemScanCompare cmp, u32 cur, u32 prev, u32 value)
+{
+    if(type == MEMSCAN_TYPE_U8)
+        value &= 0xFF;
+    else if(type == MEMSCAN_TYPE_U16)
+        value &= 0xFFFF;
+
+    // Floats are only ordered as floats, everything else is on the bit pattern
+    if(type == MEMSCAN_TYPE_FLOAT && (cmp == MEMSCAN_CMP_INCREASED || cmp == MEMSCAN_CMP_DECREASED))
+    {
+        float c, p;
+        memcpy(&c, &cur, 4);
+        memcpy(&p, &prev, 4);
+        return cmp == MEMSCAN_CMP_INCREASED ? c > p : c < p;
+    }
+
+    switch(cmp)
+    {
+        case MEMSCAN_CMP_EQUAL:     return cur == value;
+        case MEMSCAN_CMP_CHANGED:   return cur != prev;
+        case MEMSCAN_CMP_UNCHANGED: return cur == prev;
+        case MEMSCAN_CMP_INCREASED: return cur > prev;
+        case MEMSCAN_CMP_DECREASED: return cur < prev;
+        default:                    return true;
+    }
+}
+
+static u32 refFilterBitmap(u32 *bitmap, const u8 *cur, const u8 *prev, u32 count, MemScanType type, MemScanCompare cmp, u32 value)
+{
+    u32 size = MemScan_TypeSize(type);
+    u32 remaining = 0;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        if(!(bitmap[i / 32] & BIT(i % 32)))
+            continue;
+
+        // Without a previous pass, those comparisons keep everything
+        bool skip = MemScan_NeedsPrevious(cmp) && prev == NULL;
+        if(!skip && !refMatches(type, cmp, refLoad(cur + i * size, type), prev == NULL ? 0 : refLoad(prev + i * size, type), value))
+        {
+            bitmap[i / 32] &= ~BIT(i % 32);
+            continue;
+        }
+
+        remaining++;
+    }
+
+    return remaining;
+}
+
+#define MAX_COUNT   4096
+
+static u32 curBuf[MAX_COUNT], prevBuf[MAX_COUNT];
+static u32 bitmap[MAX_COUNT / 32], refBitmap[MAX_COUNT / 32];
+
+// Few distinct values, so that equal and unchanged values are common. Floats also get signed zeroes, infinities and NaNs.
+static u32 randomValue(MemScanType type)
+{
+    static const u32 floats[] = { 0x00000000, 0x80000000, 0x3F800000, 0xBF800000, 0x7F800000, 0xFF800000, 0x7FC00000, 0x40490FDB };
+    u32 r = testRandom();
+
+    if(type == MEMSCAN_TYPE_FLOAT)
+        return floats[r % 8];
+    else if(r & 1)
+        return (r >> 1) % 4;
+    else
+        return r >> 1;
+}
+
+static void fillValues(void *buf, MemScanType type, u32 count, const void *from)
+{
+    u32 size = MemScan_TypeSize(type);
+    for(u32 i = 0; i < count; i++)
+    {
+        // When there's a previous pass, keep about half of its values
+        u32 v = (from != NULL && (testRandom() & 1)) ? refLoad((const u8 *)from + i * size, type) : randomValue(type);
+        memcpy((u8 *)buf + i * size, &v, size);
+    }
+}
+
+static void testLoadAndMatches(void)
+{
+    for(u32 type = 0; type < MEMSCAN_TYPE_COUNT; type++)
+    {
+        u32 size = MemScan_TypeSize(type);
+        for(u32 iter = 0; iter < 100000; iter++)
+        {
+            u32 cur = randomValue(type), prev = randomValue(type), value = randomValue(type);
+            u32 word = cur;
+            cur = refLoad((const u8 *)&word, type);
+            prev &= size == 4 ? 0xFFFFFFFF : BIT(8 * size) - 1;
+
+            CHECK(MemScan_Load(&word, type) == cur, "%s load: %08x, expected %08x", typeNames[type], MemScan_Load(&word, type), cur);
+
+            // value is passed as the user typed it, already within range for the type
+            value &= size == 4 ? 0xFFFFFFFF : BIT(8 * size) - 1;
+            for(u32 cmp = 0; cmp < MEMSCAN_CMP_COUNT; cmp++)
+            {
+                bool m = MemScan_Matches(type, cmp, cur, prev, value);
+                bool ref = refMatches(type, cmp, cur, prev, value);
+                CHECK(m == ref, "%s %s %08x %08x %08x: %d, expected %d", typeNames[type], compareNames[cmp], cur, prev, value, m, ref);
+            }
+        }
+    }
+}
+
+static void testFilterBitmap(void)
+{
+    for(u32 iter = 0; iter < 2000; iter++)
+    {
+        MemScanType type = testRandom() % MEMSCAN_TYPE_COUNT;
+        MemScanCompare cmp = testRandom() % MEMSCAN_CMP_COUNT;
+        u32 count = 32 * (1 + testRandom() % (MAX_COUNT / 32));
+        u32 size = MemScan_TypeSize(type);
+        u32 value = randomValue(type) & (size == 4 ? 0xFFFFFFFF : BIT(8 * size) - 1);
+        bool hasPrevious = (testRandom() % 8) != 0;
+
+        fillValues(prevBuf, type, count, NULL);
+        fillValues(curBuf, type, count, prevBuf);
+
+        // Full, empty, and partial candidate sets from earlier passes
+        u32 density = testRandom() % 4;
+        for(u32 w = 0; w < count / 32; w++)
+            bitmap[w] = density == 0 ? 0xFFFFFFFF : (density == 1 ? 0 : testRandom() & (density == 2 ? 0xFFFFFFFF : testRandom()));
+        memcpy(refBitmap, bitmap, count / 8);
+
+        u32 n = MemScan_FilterBitmap(bitmap, curBuf, hasPrevious ? prevBuf : NULL, count, type, cmp, value);
+        u32 ref = refFilterBitmap(refBitmap, (const u8 *)curBuf, hasPrevious ? (const u8 *)prevBuf : NULL, count, type, cmp, value);
+
+        CHECK(n == ref, "%s %s over %u values: %u left, expected %u", typeNames[type], compareNames[cmp], count, n, ref);
+        CHECK(memcmp(bitmap, refBitmap, count / 8) == 0, "%s %s over %u values: bitmaps differ", typeNames[type], compareNames[cmp], count);
+        CHECK(MemScan_CountBits(bitmap, count / 32) == n, "%s %s: counted %u bits, %u left", typeNames[type], compareNames[cmp],
+            MemScan_CountBits(bitmap, count / 32), n);
+    }
+}
+
+#define BENCH_SIZE  (4 << 20)
+
+static void bench(void)
+{
+    u8 *cur = malloc(BENCH_SIZE), *prev = malloc(BENCH_SIZE);
+    u32 *bm = malloc(BENCH_SIZE / 8);
+
+    for(u32 i = 0; i < BENCH_SIZE; i++)
+    {
+        prev[i] = (u8)testRandom();
+        cur[i] = (testRandom() % 4) ? prev[i] : (u8)testRandom();
+    }
+
+    printf("memscan: host timings over %u MiB, a first \"unchanged\" pass then an \"equal\" pass on what's left\n", BENCH_SIZE >> 20);
+
+    for(u32 type = 0; type < MEMSCAN_TYPE_COUNT; type++)
+    {
+        u32 count = BENCH_SIZE / MemScan_TypeSize(type);
+        double times[2];
+        u32 results[2];
+
+        for(u32 naive = 0; naive < 2; naive++)
+        {
+            memset(bm, 0xFF, BENCH_SIZE / 8);
+            double start = testNow();
+            if(naive)
+            {
+                refFilterBitmap(bm, cur, prev, count, type, MEMSCAN_CMP_UNCHANGED, 0);
+                results[naive] = refFilterBitmap(bm, cur, NULL, count, type, MEMSCAN_CMP_EQUAL, 0x12);
+            }
+            else
+            {
+                MemScan_FilterBitmap(bm, cur, prev, count, type, MEMSCAN_CMP_UNCHANGED, 0);
+                results[naive] = MemScan_FilterBitmap(bm, cur, NULL, count, type, MEMSCAN_CMP_EQUAL, 0x12);
+            }
+            times[naive] = testNow() - start;
+        }
+
+        CHECK(results[0] == results[1], "%s bench: %u left, expected %u", typeNames[type], results[0], results[1]);
+        printf("  %-6s %8.2f ms, naive %8.2f ms\n", typeNames[type], 1e3 * times[0], 1e3 * times[1]);
+    }
+
+    free(cur);
+    free(prev);
+    free(bm);
+}
+
+int main(int argc, char **argv)
+{
+    testLoadAndMatches();
+    testFilterBitmap();
+
+    if(testWantsBench(argc, argv))
+        bench();
+
+    return testReport("memscan");
+}
@@ -0,0 +1,236 @@
+// The loader's pattern search (sysmodules/loader/source/memory.c), checked against a naive search, and
+// memsearchMultiUpdate against searching again after every patch
+
+#include "test.h"
+#include "memory.h"
+
+static u8 *naiveSearch(u8 *startPos, u32 size, const void *pattern, u32 patternSize)
+{
+    if(patternSize == 0)
+        return NULL;
+
+    for(u32 i = 0; i + patternSize <= size; i++)
+    {
+        if(memcmp(startPos + i, pattern, patternSize) == 0)
+            return startPos + i;
+    }
+
+    return NULL;
+}
+
+// The search as it was, one pass per pattern with a u32 skip table
+static u8 *Ref_memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
+{
+    const u8 *patternc = (const u8 *)pattern;
+    u32 table[256];
+
+    //Preprocessing
+    for(u32 i = 0; i < 256; i++)
+        table[i] = patternSize;
+    for(u32 i = 0; i < patternSize - 1; i++)
+        table[patternc[i]] = patternSize - i - 1;
+
+    //Searching
+    u32 j = 0;
+    while(j <= size - patternSize)
+    {
+        u8 c = startPos[j + patternSize - 1];
+        if(patternc[patternSize - 1] == c && memcmp(pattern, startPos + j, patternSize - 1) == 0)
+            return startPos + j;
+        j += table[c];
+    }
+
+    return NULL;
+}
+
+#define MAX_PATTERNS    4
+
+static u8 code[1024], refCode[1024];
+static u8 patternData[MAX_PATTERNS][512];
+
+// A small alphabet makes for plenty of partial and overlapping matches
+static void fillSmall(u8 *buf, u32 len, u32 alphabet)
+{
+    for(u32 i = 0; i < len; i++)
+        buf[i] = (u8)(testRandom() % alphabet);
+}
+
+static void testMemsearch(void)
+{
+    for(u32 iter = 0; iter < 200000; iter++)
+    {
+        u32 alphabet = 2 + testRandom() % 4;
+        u32 size = testRandom() % sizeof(code);
+        // Long patterns too, past the 255 bytes a shift can hold
+        u32 patternSize = (testRandom() & 7) == 0 ? 200 + testRandom() % 312 : 1 + testRandom() % 8;
+
+        fillSmall(code, size, alphabet);
+        if(patternSize <= size && (testRandom() & 1))
+            memcpy(patternData[0], code + testRandom() % (size - patternSize + 1), patternSize);
+        else
+            fillSmall(patternData[0], patternSize, alphabet);
+
+        u8 *found = memsearch(code, patternData[0], size, patternSize);
+        u8 *ref = naiveSearch(code, size, patternData[0], patternSize);
+        CHECK(found == ref, "pattern of %u bytes in %u bytes: found at %ld, expected %ld", patternSize, size,
+            found == NULL ? -1L : (long)(found - code), ref == NULL ? -1L : (long)(ref - code));
+    }
+}
+
+static void testMemsearchMulti(void)
+{
+    MemsearchPattern patterns[MAX_PATTERNS];
+
+    for(u32 iter = 0; iter < 200000; iter++)
+    {
+        u32 alphabet = 2 + testRandom() % 4;
+        u32 size = testRandom() % 512;
+        u32 count = 1 + testRandom() % MAX_PATTERNS;
+
+        fillSmall(code, size, alphabet);
+        for(u32 i = 0; i < count; i++)
+        {
+            patterns[i].size = (testRandom() & 15) == 0 ? 256 + testRandom() % 256 : 1 + testRandom() % 12;
+            patterns[i].pattern = patternData[i];
+            if(patterns[i].size <= size && (testRandom() & 1))
+                memcpy(patternData[i], code + testRandom() % (size - patterns[i].size + 1), patterns[i].size);
+            else
+                fillSmall(patternData[i], patterns[i].size, alphabet);
+        }
+
+        u32 found = memsearchMulti(code, size, patterns, count);
+        u32 refFound = 0;
+        for(u32 i = 0; i < count; i++)
+        {
+            u8 *ref = naiveSearch(code, size, patterns[i].pattern, patterns[i].size);
+            CHECK(patterns[i].result == ref, "pattern %u/%u of %u bytes in %u bytes: found at %ld, expected %ld", i, count,
+                patterns[i].size, size, patterns[i].result == NULL ? -1L : (long)(patterns[i].result - code),
+                ref == NULL ? -1L : (long)(ref - code));
+            refFound += ref != NULL;
+        }
+
+        CHECK(found == refFound, "%u patterns in %u bytes: %u found, expected %u", count, size, found, refFound);
+    }
+}
+
+// Patches applied one after the other, each at an offset from the first match of its pattern: memsearchMulti then
+// memsearchMultiUpdate after every patch must give the same code as searching the whole buffer before every patch
+static void testMemsearchMultiUpdate(void)
+{
+    MemsearchPattern patterns[MAX_PATTERNS];
+    u8 replacements[MAX_PATTERNS][8];
+    u32 replacementSizes[MAX_PATTERNS];
+    s32 offsets[MAX_PATTERNS];
+    u32 applied = 0;
+
+    for(u32 iter = 0; iter < 300000; iter++)
+    {
+        u32 size = 16 + testRandom() % 200;
+        u32 count = 1 + testRandom() % MAX_PATTERNS;
+
+        fillSmall(code, size, 3);
+        memcpy(refCode, code, size);
+        for(u32 i = 0; i < count; i++)
+        {
+            patterns[i].size = 1 + testRandom() % 4;
+            patterns[i].pattern = patternData[i];
+            fillSmall(patternData[i], patterns[i].size, 3);
+            replacementSizes[i] = 1 + testRandom() % 8;
+            fillSmall(replacements[i], replacementSizes[i], 3);
+            offsets[i] = (s32)(testRandom() % 13) - 6;
+        }
+
+        bool refOk = true;
+        for(u32 i = 0; i < count && refOk; i++)
+        {
+            u8 *pos = naiveSearch(refCode, size, patterns[i].pattern, patterns[i].size);
+            refOk = pos != NULL && pos + offsets[i] >= refCode && pos + offsets[i] + replacementSizes[i] <= refCode + size;
+            if(refOk)
+                memcpy(pos + offsets[i], replacements[i], replacementSizes[i]);
+        }
+
+        memsearchMulti(code, size, patterns, count);
+        bool ok = true;
+        for(u32 i = 0; i < count && ok; i++)
+        {
+            u8 *pos = patterns[i].result;
+            ok = pos != NULL && pos + offsets[i] >= code && pos + offsets[i] + replacementSizes[i] <= code + size;
+            if(ok)
+            {
+                memcpy(pos + offsets[i], replacements[i], replacementSizes[i]);
+                memsearchMultiUpdate(code, size, patterns + i + 1, count - i - 1, pos + offsets[i], replacementSizes[i]);
+            }
+        }
+
+        CHECK(ok == refOk, "%u patches in %u bytes: %s, expected %s", count, size, ok ? "applied" : "failed", refOk ? "applied" : "failed");
+        CHECK(!ok || !refOk || memcmp(code, refCode, size) == 0, "%u patches in %u bytes: patched code differs", count, size);
+        applied += ok && refOk;
+    }
+
+    // Most runs fail early with such short buffers, make sure enough of them went all the way
+    CHECK(applied > 10000, "only %u runs applied all their patches", applied);
+}
+
+#define BENCH_SIZE      (4 << 20)
+#define BENCH_PATTERNS  4
+
+static void bench(void)
+{
+    u8 *buf = malloc(BENCH_SIZE);
+    MemsearchPattern patterns[BENCH_PATTERNS];
+
+    // Something like ARM code, with patterns of the length the patcher uses that only show up near the end
+    for(u32 i = 0; i < BENCH_SIZE; i += 4)
+    {
+        u32 insn = 0xE0000000 | (testRandom() & 0x0FFFFFFF);
+        memcpy(buf + i, &insn, 4);
+    }
+
+    for(u32 i = 0; i < BENCH_PATTERNS; i++)
+    {
+        patterns[i].size = 8 + 4 * i;
+        patterns[i].pattern = buf + BENCH_SIZE - 0x1000 * (i + 1);
+    }
+
+    printf("memsearch: host timings for %u patterns in %u MiB\n", BENCH_PATTERNS, BENCH_SIZE >> 20);
+
+    double times[3];
+    bool ok = true;
+    const u32 iterations = 20;
+
+    double start = testNow();
+    for(u32 iter = 0; iter < iterations; iter++)
+        for(u32 i = 0; i < BENCH_PATTERNS; i++)
+            ok = ok && Ref_memsearch(buf, patterns[i].pattern, BENCH_SIZE, patterns[i].size) == patterns[i].pattern;
+    times[0] = testNow() - start;
+
+    start = testNow();
+    for(u32 iter = 0; iter < iterations; iter++)
+        for(u32 i = 0; i < BENCH_PATTERNS; i++)
+            ok = ok && memsearch(buf, patterns[i].pattern, BENCH_SIZE, patterns[i].size) == patterns[i].pattern;
+    times[1] = testNow() - start;
+
+    start = testNow();
+    for(u32 iter = 0; iter < iterations; iter++)
+        ok = ok && memsearchMulti(buf, BENCH_SIZE, patterns, BENCH_PATTERNS) == BENCH_PATTERNS;
+    times[2] = testNow() - start;
+
+    CHECK(ok, "bench searches didn't find their patterns");
+    printf("  %-32s %8.2f ms\n", "memsearch per pattern (old)", 1e3 * times[0] / iterations);
+    printf("  %-32s %8.2f ms\n", "memsearch per pattern", 1e3 * times[1] / iterations);
+    printf("  %-32s %8.2f ms\n", "memsearchMulti", 1e3 * times[2] / iterations);
+
+    free(buf);
+}
+
+int main(int argc, char **argv)
+{
+    testMemsearch();
+    testMemsearchMulti();
+    testMemsearchMultiUpdate();
+
+    if(testWantsBench(argc, argv))
+        bench();
+
+    return testReport("memsearch");
+}
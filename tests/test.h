@@ -0,0 +1,65 @@
+// Shared helpers of the host tests
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <3ds/types.h>
+
+static u32 testFailures = 0;
+
+#define CHECK(cond, ...)\
+do\
+{\
+    if(!(cond))\
+    {\
+        if(testFailures++ < 10)\
+        {\
+            printf("%s:%d: ", __FILE__, __LINE__);\
+            printf(__VA_ARGS__);\
+            printf("\n");\
+        }\
+    }\
+}\
+while(0)
+
+// xorshift32, so that runs are reproducible
+static u32 testRngState = 0x12345678;
+
+static inline u32 testRandom(void)
+{
+    testRngState ^= testRngState << 13;
+    testRngState ^= testRngState >> 17;
+    testRngState ^= testRngState << 5;
+    return testRngState;
+}
+
+static inline void testFillRandom(void *buf, u32 len)
+{
+    for(u32 i = 0; i < len; i++)
+        ((u8 *)buf)[i] = (u8)testRandom();
+}
+
+static inline double testNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline bool testWantsBench(int argc, char **argv)
+{
+    return argc > 1 && strcmp(argv[1], "--bench") == 0;
+}
+
+static inline int testReport(const char *name)
+{
+    if(testFailures != 0)
+        printf("%s: %u failure(s)\n", name, testFailures);
+    else
+        printf("%s: OK\n", name);
+
+    return testFailures != 0;
+}